@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Triangle.hpp"
+
+#include <vector>
+#include <cmath>
+
+//UV sphere, rings from the top down to numRings are generated, fewer rings than segments leave a hole at the bottom
+inline void generateSphere(const glm::vec3& center, float radius, unsigned int numSegments, unsigned int numRings, std::vector<Triangle>& triangles)
+{
+	const float pi = 3.14159265f;
+
+	auto getPoint = [&](unsigned int i, unsigned int j)
+	{
+		const float theta = pi * i / numSegments;
+		const float phi = 2 * pi * j / numSegments;
+		return glm::vec4(center + radius * glm::vec3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)), 1);
+	};
+
+	for (unsigned int i = 0; i < numRings; ++i)
+	{
+		for (unsigned int j = 0; j < numSegments; ++j)
+		{
+			if (i != 0)
+				triangles.push_back({ getPoint(i, j), getPoint(i, j + 1), getPoint(i + 1, j + 1) });
+
+			if (i != (numSegments - 1))
+				triangles.push_back({ getPoint(i, j), getPoint(i + 1, j + 1), getPoint(i + 1, j) });
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#include "BenchmarkScene.hpp"
+#include "EdgeMultiplicityEvaluator.hpp"
+#include "EdgeExtractor.hpp"
+#include "GeometryOperations.hpp"
+#include "HighResolutionTimer.hpp"
+
+#include <vector>
+#include <random>
+#include <iostream>
+#include <cstdlib>
+
+#define BENCHMARK_SPHERE_SEGMENTS 128
+#define BENCHMARK_NUM_RANDOM_LIGHTS 64
+#define BENCHMARK_NUM_VERTEX_LIGHTS 64
+
+static const char* getImplementationName(EdgeMultiplicityEvaluator::Implementation implementation)
+{
+	return implementation == EdgeMultiplicityEvaluator::Implementation::AVX2 ? "avx2" : "scalar";
+}
+
+int main()
+{
+	//The missing bottom rings leave open edges with one opposite vertex
+	std::vector<Triangle> triangles;
+	generateSphere(glm::vec3(0), 1.0f, BENCHMARK_SPHERE_SEGMENTS, BENCHMARK_SPHERE_SEGMENTS - 2, triangles);
+
+	EdgeStore edges;
+	EdgeExtractor().extractEdgesFromTriangles(triangles, edges);
+
+	//All edges are passed, like a light containing the whole mesh in one potential list
+	std::vector<int> edgeIDs;
+	for (unsigned int i = 0; i < edges.size(); ++i)
+	{
+		if (edges.getNumOppositeVertices(i) > 0)
+			edgeIDs.push_back(i);
+	}
+
+	//Lights in mesh vertices lie in the planes of their triangles, those edges need the exact orientation
+	std::vector<glm::vec3> lights;
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-3.0f, 3.0f);
+
+	for (unsigned int i = 0; i < BENCHMARK_NUM_RANDOM_LIGHTS; ++i)
+		lights.push_back(glm::vec3(position(generator), position(generator), position(generator)));
+
+	for (unsigned int i = 0; i < BENCHMARK_NUM_VERTEX_LIGHTS; ++i)
+		lights.push_back(edges.getLowerPoint(edgeIDs[generator() % edgeIDs.size()]));
+
+	std::cout << edgeIDs.size() << " edges, " << lights.size() << " lights" << std::endl;
+
+	std::vector<int> referenceMultiplicities(lights.size() * edgeIDs.size());
+
+	HighResolutionTimer timer;
+	timer.reset();
+
+	for (size_t l = 0; l < lights.size(); ++l)
+	{
+		for (size_t i = 0; i < edgeIDs.size(); ++i)
+			referenceMultiplicities[l * edgeIDs.size() + i] = GeometryOps::calcEdgeMultiplicity(edges, edgeIDs[i], lights[l]);
+	}
+
+	const double referenceMs = timer.getElapsedTimeMilliseconds() / lights.size();
+	std::cout << "calcEdgeMultiplicity per edge " << referenceMs << " ms per light" << std::endl;
+
+	bool isBitIdentical = true;
+
+	const EdgeMultiplicityEvaluator::Implementation implementations[] = { EdgeMultiplicityEvaluator::Implementation::SCALAR, EdgeMultiplicityEvaluator::Implementation::AVX2 };
+	for (const auto implementation : implementations)
+	{
+		const EdgeMultiplicityEvaluator evaluator(implementation);
+
+		if (evaluator.getImplementation() != implementation)
+		{
+			std::cout << getImplementationName(implementation) << " not supported" << std::endl;
+			continue;
+		}
+
+		std::vector<int> multiplicities;
+		unsigned int numMismatches = 0;
+		double evaluatorMs = 0;
+
+		for (size_t l = 0; l < lights.size(); ++l)
+		{
+			timer.reset();
+			evaluator.computeMultiplicities(edges, edgeIDs, lights[l], multiplicities);
+			evaluatorMs += timer.getElapsedTimeMilliseconds();
+
+			for (size_t i = 0; i < edgeIDs.size(); ++i)
+				numMismatches += multiplicities[i] != referenceMultiplicities[l * edgeIDs.size() + i];
+		}
+
+		evaluatorMs /= lights.size();
+		std::cout << "EdgeMultiplicityEvaluator " << getImplementationName(implementation) << " " << evaluatorMs << " ms per light, speedup " << referenceMs / evaluatorMs << "x, mismatches " << numMismatches << std::endl;
+
+		isBitIdentical &= numMismatches == 0;
+	}
+
+	return isBitIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
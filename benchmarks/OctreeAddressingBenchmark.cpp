@@ -0,0 +1,125 @@
+#include "OctreeAddressing.hpp"
+#include "HighResolutionTimer.hpp"
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+
+#define BENCHMARK_DEPTH 7
+#define BENCHMARK_NUM_REPEATS 10
+
+//Addressing of the octree before the closed form, levels are found by scanning the prefix sums of level sizes
+class LinearScanAddressing
+{
+public:
+	LinearScanAddressing(unsigned int deepestLevel)
+	{
+		unsigned int prefixSum = 0;
+
+		for (unsigned int i = 0; i <= deepestLevel; ++i)
+		{
+			const unsigned int levelSize = 1u << (3 * i);
+			_levelSizesInclusiveSum.push_back(levelSize + prefixSum);
+			prefixSum += levelSize;
+		}
+	}
+
+	int getNodeLevel(unsigned int nodeID) const
+	{
+		int level = 0;
+		for (auto size : _levelSizesInclusiveSum)
+		{
+			if (nodeID < size)
+				return level;
+
+			++level;
+		}
+
+		return -1;
+	}
+
+	int getNodeParent(unsigned int nodeID) const
+	{
+		if (nodeID == 0)
+			return -1;
+
+		const int level = getNodeLevel(nodeID);
+		const int parentRelativeID = (nodeID - _getNumNodesInPreviousLevels(level)) / OCTREE_NUM_CHILDREN;
+
+		return parentRelativeID + _getNumNodesInPreviousLevels(level - 1);
+	}
+
+	int getChildrenStartingID(unsigned int nodeID) const
+	{
+		const int level = getNodeLevel(nodeID);
+
+		return (nodeID - _getNumNodesInPreviousLevels(level)) * OCTREE_NUM_CHILDREN + _getNumNodesInPreviousLevels(level + 1);
+	}
+
+private:
+	unsigned int _getNumNodesInPreviousLevels(int level) const
+	{
+		const int l = level - 1;
+
+		if (l < 0 || l >= int(_levelSizesInclusiveSum.size()))
+			return 0;
+
+		return _levelSizesInclusiveSum[l];
+	}
+
+	std::vector<unsigned int> _levelSizesInclusiveSum;
+};
+
+typedef OctreeAddressing<OCTREE_MAX_DEPTH> Addressing;
+
+//Level, parent and first child of every node above the deepest level, like the visitor's traversals ask for them
+template<typename LevelFunc, typename ParentFunc, typename ChildrenFunc>
+double measureNanosecondsPerNode(unsigned int numNodes, LevelFunc getLevel, ParentFunc getParent, ChildrenFunc getChildren, uint64_t& checksum)
+{
+	HighResolutionTimer timer;
+	timer.reset();
+
+	for (unsigned int r = 0; r < BENCHMARK_NUM_REPEATS; ++r)
+	{
+		for (unsigned int nodeID = 1; nodeID < numNodes; ++nodeID)
+			checksum += getLevel(nodeID) + getParent(nodeID) + getChildren(nodeID);
+	}
+
+	return timer.getElapsedTimeMilliseconds() * TIMER_NS_PER_MILLISECOND / (double(numNodes) * BENCHMARK_NUM_REPEATS);
+}
+
+int main()
+{
+	const LinearScanAddressing linearScan(BENCHMARK_DEPTH);
+	const unsigned int numNodes = Addressing::getLevelFirstNodeID(BENCHMARK_DEPTH);
+
+	for (unsigned int nodeID = 1; nodeID < numNodes; ++nodeID)
+	{
+		if (linearScan.getNodeLevel(nodeID) != int(Addressing::getNodeLevel(nodeID)) ||
+			linearScan.getNodeParent(nodeID) != int(Addressing::getNodeParent(nodeID)) ||
+			linearScan.getChildrenStartingID(nodeID) != int(Addressing::getChildrenStartingID(nodeID)))
+		{
+			std::cout << "Addressing differs at node " << nodeID << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	uint64_t linearChecksum = 0, closedChecksum = 0;
+
+	const double linearNs = measureNanosecondsPerNode(numNodes,
+		[&](unsigned int id) { return linearScan.getNodeLevel(id); },
+		[&](unsigned int id) { return linearScan.getNodeParent(id); },
+		[&](unsigned int id) { return linearScan.getChildrenStartingID(id); },
+		linearChecksum);
+
+	const double closedNs = measureNanosecondsPerNode(numNodes,
+		[](unsigned int id) { return Addressing::getNodeLevel(id); },
+		[](unsigned int id) { return Addressing::getNodeParent(id); },
+		[](unsigned int id) { return Addressing::getChildrenStartingID(id); },
+		closedChecksum);
+
+	std::cout << "Depth " << BENCHMARK_DEPTH << ", " << numNodes << " nodes above the deepest level" << std::endl;
+	std::cout << "Linear scan " << linearNs << " ns/node, closed form " << closedNs << " ns/node, speedup " << linearNs / closedNs << "x" << std::endl;
+
+	return linearChecksum == closedChecksum ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,138 @@
+#include "BenchmarkScene.hpp"
+#include "SyblingEdgeClassifier.hpp"
+#include "EdgeExtractor.hpp"
+#include "Octree.hpp"
+#include "HighResolutionTimer.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+#define BENCHMARK_DEPTH 4
+#define BENCHMARK_SPHERE_SEGMENTS 32
+#define BENCHMARK_NUM_REPEATS 3
+
+//Children of the nodes one level above the leaves, the syblings the bottom-level pass classifies edges against
+static void getBottomLevelSyblings(const Octree& octree, std::vector<AABB>& volumes)
+{
+	const unsigned int firstParent = octree.getLevelFirstNodeID(octree.getDeepestLevel() - 1);
+	const unsigned int firstLeaf = octree.getLevelFirstNodeID(octree.getDeepestLevel());
+
+	for (unsigned int parent = firstParent; parent < firstLeaf; ++parent)
+	{
+		const int startingChild = octree.getChildrenStartingId(parent);
+
+		for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+			volumes.push_back(octree.calculateNodeVolume(startingChild + i));
+	}
+}
+
+static const char* getImplementationName(SyblingEdgeClassifier::Implementation implementation)
+{
+	switch (implementation)
+	{
+	case SyblingEdgeClassifier::Implementation::AVX:
+		return "avx";
+	case SyblingEdgeClassifier::Implementation::SSE:
+		return "sse";
+	default:
+		return "scalar";
+	}
+}
+
+int main()
+{
+	std::vector<Triangle> triangles;
+	generateSphere(glm::vec3(0), 1.0f, BENCHMARK_SPHERE_SEGMENTS, BENCHMARK_SPHERE_SEGMENTS, triangles);
+
+	EdgeStore edges;
+	EdgeExtractor().extractEdgesFromTriangles(triangles, edges);
+
+	std::vector<unsigned int> closedEdges;
+	for (unsigned int i = 0; i < edges.size(); ++i)
+	{
+		if (edges.getNumOppositeVertices(i) == 2)
+			closedEdges.push_back(i);
+	}
+
+	const Octree octree(BENCHMARK_DEPTH, AABB(glm::vec3(-2), glm::vec3(2)));
+
+	std::vector<AABB> volumes;
+	getBottomLevelSyblings(octree, volumes);
+
+	const size_t numGroups = volumes.size() / SYBLING_CLASSIFIER_NUM_VOLUMES;
+
+	std::cout << closedEdges.size() << " edges, " << numGroups << " sybling groups on level " << BENCHMARK_DEPTH << std::endl;
+
+	//Reference is the per-volume test the bottom-level pass used before
+	std::vector<EdgeSilhouetness> referenceResults(numGroups * closedEdges.size() * SYBLING_CLASSIFIER_NUM_VOLUMES);
+
+	HighResolutionTimer timer;
+	timer.reset();
+
+	for (unsigned int r = 0; r < BENCHMARK_NUM_REPEATS; ++r)
+	{
+		EdgeSilhouetness* result = referenceResults.data();
+
+		for (size_t group = 0; group < numGroups; ++group)
+		{
+			const AABB* groupVolumes = volumes.data() + group * SYBLING_CLASSIFIER_NUM_VOLUMES;
+
+			for (const auto edge : closedEdges)
+			{
+				for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+					*result++ = GeometryOps::testEdgeSpaceAabb(edges, edge, groupVolumes[i]);
+			}
+		}
+	}
+
+	const double referenceMs = timer.getElapsedTimeMilliseconds() / BENCHMARK_NUM_REPEATS;
+	std::cout << "testEdgeSpaceAabb per volume " << referenceMs << " ms" << std::endl;
+
+	bool isBitExact = true;
+
+	const SyblingEdgeClassifier::Implementation implementations[] = { SyblingEdgeClassifier::Implementation::SCALAR, SyblingEdgeClassifier::Implementation::SSE, SyblingEdgeClassifier::Implementation::AVX };
+	for (const auto implementation : implementations)
+	{
+		SyblingEdgeClassifier classifier(implementation);
+
+		if (classifier.getImplementation() != implementation)
+		{
+			std::cout << getImplementationName(implementation) << " not supported" << std::endl;
+			continue;
+		}
+
+		unsigned int numMismatches = 0;
+
+		timer.reset();
+
+		for (unsigned int r = 0; r < BENCHMARK_NUM_REPEATS; ++r)
+		{
+			const EdgeSilhouetness* reference = referenceResults.data();
+
+			for (size_t group = 0; group < numGroups; ++group)
+			{
+				AABB groupVolumes[SYBLING_CLASSIFIER_NUM_VOLUMES];
+				std::copy(volumes.begin() + group * SYBLING_CLASSIFIER_NUM_VOLUMES, volumes.begin() + (group + 1) * SYBLING_CLASSIFIER_NUM_VOLUMES, groupVolumes);
+				classifier.setVolumes(groupVolumes);
+
+				for (const auto edge : closedEdges)
+				{
+					EdgeSilhouetness results[SYBLING_CLASSIFIER_NUM_VOLUMES];
+					classifier.classifyEdge(edges, edge, results);
+
+					for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+						numMismatches += results[i] != *reference++;
+				}
+			}
+		}
+
+		const double classifierMs = timer.getElapsedTimeMilliseconds() / BENCHMARK_NUM_REPEATS;
+		std::cout << "SyblingEdgeClassifier " << getImplementationName(implementation) << " " << classifierMs << " ms, speedup " << referenceMs / classifierMs << "x, mismatches " << numMismatches / BENCHMARK_NUM_REPEATS << std::endl;
+
+		isBitExact &= numMismatches == 0;
+	}
+
+	return isBitExact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+#include "AbstractSilhouetteMethod.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+void AbstractSilhouetteMethod::getSilhouetteEdgesForLightPositions(const glm::vec3* lightPositions, size_t numLights, MultiLightSilhouetteEdges& result) const
+{
+	const int numLightsInt = int(numLights);
+
+	std::vector<int> lightKeys(numLights);
+
+	#pragma omp parallel for
+	for (int i = 0; i < numLightsInt; ++i)
+		lightKeys[i] = _getLightGroupKey(lightPositions[i]);
+
+	std::vector<unsigned int> sortedLights(numLights);
+	std::iota(sortedLights.begin(), sortedLights.end(), 0);
+	std::stable_sort(sortedLights.begin(), sortedLights.end(), [&lightKeys](unsigned int a, unsigned int b) { return lightKeys[a] < lightKeys[b]; });
+
+	//Lights outside of the structure get an empty result, they form no group
+	std::vector<int> lightGroups(numLights, -1);
+	std::vector<glm::vec3> groupLightPositions;
+
+	for (size_t i = 0; i < numLights; ++i)
+	{
+		const unsigned int light = sortedLights[i];
+
+		if (lightKeys[light] < 0)
+			continue;
+
+		if (groupLightPositions.empty() || lightKeys[light] != lightKeys[sortedLights[i - 1]])
+			groupLightPositions.push_back(lightPositions[light]);
+
+		lightGroups[light] = int(groupLightPositions.size()) - 1;
+	}
+
+	std::vector< std::vector<int> > groupPotential(groupLightPositions.size());
+	std::vector< std::vector<int> > groupSilhouette(groupLightPositions.size());
+
+	_getLightGroupsSilhouetteEdges(groupLightPositions, groupPotential, groupSilhouette);
+
+	result.potentialOffsets.resize(numLights + 1);
+	result.silhouetteOffsets.resize(numLights + 1);
+	result.potentialOffsets[0] = 0;
+	result.silhouetteOffsets[0] = 0;
+
+	for (size_t i = 0; i < numLights; ++i)
+	{
+		const int group = lightGroups[i];
+
+		result.potentialOffsets[i + 1] = result.potentialOffsets[i] + (group >= 0 ? groupPotential[group].size() : 0);
+		result.silhouetteOffsets[i + 1] = result.silhouetteOffsets[i] + (group >= 0 ? groupSilhouette[group].size() : 0);
+	}
+
+	result.potentialEdges.resize(result.potentialOffsets[numLights]);
+	result.silhouetteEdges.resize(result.silhouetteOffsets[numLights]);
+
+	#pragma omp parallel for
+	for (int i = 0; i < numLightsInt; ++i)
+	{
+		const int group = lightGroups[i];
+
+		if (group < 0)
+			continue;
+
+		std::copy(groupPotential[group].begin(), groupPotential[group].end(), result.potentialEdges.begin() + result.potentialOffsets[i]);
+		std::copy(groupSilhouette[group].begin(), groupSilhouette[group].end(), result.silhouetteEdges.begin() + result.silhouetteOffsets[i]);
+	}
+}
+
+void AbstractSilhouetteMethod::_getLightGroupsSilhouetteEdges(const std::vector<glm::vec3>& groupLightPositions, std::vector< std::vector<int> >& potential, std::vector< std::vector<int> >& silhouette) const
+{
+	const int numGroups = int(groupLightPositions.size());
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < numGroups; ++i)
+	{
+		SilhouetteEdgeCollector collector(potential[i], silhouette[i]);
+		visitSilhouetteEdgesForLightPos(groupLightPositions[i], collector);
+	}
+}
+
+int AbstractSilhouetteMethod::_getLightGroupKey(const glm::vec3& /*lightPos*/) const
+{
+	return 0;
+}
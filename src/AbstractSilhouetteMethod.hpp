@@ -1,9 +1,22 @@
 #pragma once
 
 #include <vector>
+#include <string>
 
-#include "Edge.hpp"
+#include "EdgeStore.hpp"
 #include "AABB.hpp"
+#include "SilhouetteEdgeVisitor.hpp"
+#include "BuildReport.hpp"
+
+//Results of several lights in flat arrays, light i owns entries [offsets[i], offsets[i + 1])
+struct MultiLightSilhouetteEdges
+{
+	std::vector<int>	potentialEdges;
+	std::vector<int>	silhouetteEdges;
+
+	std::vector<size_t> potentialOffsets;
+	std::vector<size_t> silhouetteOffsets;
+};
 
 class AbstractSilhouetteMethod
 {
@@ -14,13 +27,45 @@ public:
 
 	//Sem dve varianty - potencialne a iste
 	virtual void getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices) = 0;
+	//Same result passed as ranges, does not allocate nor log, so it can be called at a high rate
+	virtual void visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const = 0;
 
-	virtual void initialize(const EDGE_CONTAINER_TYPE& edges, const AABB& lightSpace, void* customParams) = 0;
+	//Lights sharing a cell of the structure are evaluated once, cells are evaluated in parallel
+	virtual void getSilhouetteEdgesForLightPositions(const glm::vec3* lightPositions, size_t numLights, MultiLightSilhouetteEdges& result) const;
+
+	virtual void initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams) = 0;
 
 	virtual void clear() = 0;
 
 	virtual uint64_t getAccelerationStructureSizeBytes() const = 0;
 
+	//Binary cache of the built structure, keyed by the edges, light space and method parameters it was built from
+	virtual bool save(const std::string& path) const = 0;
+	//Maps the file instead of reading it, fails if the cache was built from a different input
+	virtual bool load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams) = 0;
+
+	//Returns true if the structure was loaded from the cache, otherwise builds it and stores it into the cache
+	bool initializeCached(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams)
+	{
+		if (load(path, edges, lightSpace, customParams))
+			return true;
+
+		initialize(edges, lightSpace, customParams);
+		save(path);
+
+		return false;
+	}
+
+	//Statistics of the last initialize and the updates since, empty if the structure was loaded from the cache
+	const BuildReport& getBuildReport() const { return _buildReport; }
+
 protected:
 
-};
\ No newline at end of file
+	//Lights with the same key get the same result, negative key means the light is outside of the structure
+	//All lights form one group unless overridden
+	virtual int _getLightGroupKey(const glm::vec3& lightPos) const;
+	//One light position per group, groups come ordered by their key
+	virtual void _getLightGroupsSilhouetteEdges(const std::vector<glm::vec3>& groupLightPositions, std::vector< std::vector<int> >& potential, std::vector< std::vector<int> >& silhouette) const;
+
+	BuildReport _buildReport;
+};
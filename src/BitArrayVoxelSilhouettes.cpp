@@ -1,9 +1,12 @@
 #include "BitArrayVoxelSilhouettes.hpp"
 
 #include "GeometryOperations.hpp"
+#include "LatticeEdgeClassifier.hpp"
 #include "VoxelSpace.hpp"
 #include <iostream>
 
+#define VOXEL_SILHOUETTES_CHUNK_SIZE 256
+
 BitArrayVoxelSilhouettes::BitArrayVoxelSilhouettes() : AbstractSilhouetteMethod()
 {
 	BitArrayVoxelSilhouettes::clear();
@@ -14,113 +17,263 @@ BitArrayVoxelSilhouettes::~BitArrayVoxelSilhouettes()
 	
 }
 
-void BitArrayVoxelSilhouettes::initialize(const EDGE_CONTAINER_TYPE& edges, const AABB& lightSpace, void* customParams)
+void BitArrayVoxelSilhouettes::initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams)
 {
-	_edgeBitmasks.clear();
+	clear();
 
 	const auto params = reinterpret_cast<VoxelParams*>(customParams);
 
+	_cacheKey = _getCacheKey(edges, lightSpace, params);
 	_voxelizedSpace.init(lightSpace, params->numVoxelsX, params->numVoxelsY, params->numVoxelsZ);
 
-	unsigned int edgeIndex = 0;
-	for (const auto& edge : edges)
+	_numBitsPerCell = 3;
+	_numEdges = edges.size();
+	_arraySizePerEdge = MultiBitArray(_numBitsPerCell, _voxelizedSpace.getNumVoxels()).getArraySize();
+
+	//Edges without opposite vertices keep their zeroed (non-silhouette) slot, so that indices match
+	std::vector<uint32_t> edgeBitmasks(uint64_t(_numEdges) * _arraySizePerEdge, 0);
+
+	BuildReport::PhaseTimer classifyPhase(_buildReport, "classifyVoxels");
+
+	//Per-voxel list lengths a query would get, for the report
+	const unsigned int numVoxels = _voxelizedSpace.getNumVoxels();
+	std::vector<unsigned int> numVoxelPotential(numVoxels, 0);
+	std::vector<unsigned int> numVoxelSilhouette(numVoxels, 0);
+	unsigned int numOpenEdges = 0;
+	EdgeTestCounters edgeTests;
+
+	//Voxels are products of their intervals along the axes
+	LatticeEdgeClassifier lattice;
+	const unsigned int numVoxelsPerAxis[LATTICE_CLASSIFIER_NUM_AXES] = { params->numVoxelsX, params->numVoxelsY, params->numVoxelsZ };
+
+	for (unsigned int axis = 0; axis < LATTICE_CLASSIFIER_NUM_AXES; ++axis)
 	{
-		assert(edge.second.size() <= 2);
+		std::vector<float> lower(numVoxelsPerAxis[axis]);
+		std::vector<float> upper(numVoxelsPerAxis[axis]);
 
-		//assert(edge.second.size() != 0);
-		if (edge.second.size() == 0)
+		for (unsigned int i = 0; i < numVoxelsPerAxis[axis]; ++i)
 		{
-			edgeIndex++;
-			continue;
+			AABB voxel;
+			_voxelizedSpace.getVoxelFromCoords(axis == 0 ? i : 0, axis == 1 ? i : 0, axis == 2 ? i : 0, voxel);
+
+			lower[i] = voxel.getMinPoint()[axis];
+			upper[i] = voxel.getMaxPoint()[axis];
 		}
-		MultiBitArray ma(3, _voxelizedSpace.getNumVoxels());
 
-		if (edge.second.size() == 1)
+		lattice.setAxis(axis, lower, upper);
+	}
+
+	std::vector<EdgeSilhouetness> voxelResults(numVoxels);
+
+	for (unsigned int edgeIndex = 0; edgeIndex < _numEdges; ++edgeIndex)
+	{
+		const unsigned int numOppositeVertices = edges.getNumOppositeVertices(edgeIndex);
+
+		assert(numOppositeVertices <= 2);
+
+		//assert(numOppositeVertices != 0);
+		if (numOppositeVertices == 0)
+			continue;
+
+		//Cells are written straight to the edge's slot
+		uint32_t* edgeBitmask = edgeBitmasks.data() + uint64_t(edgeIndex) * _arraySizePerEdge;
+
+		if (numOppositeVertices == 1)
 		{
-			ma.setAllCells(int(EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)); //To force multiplicity calculation due to sides winding
+			//To force multiplicity calculation due to sides winding
+			for (unsigned int i = 0; i < numVoxels; ++i)
+				MultiBitArray::setCellContent(edgeBitmask, _numBitsPerCell, i, uint32_t(EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE));
+
+			++numOpenEdges;
 		}
 		else
 		{
-			Plane p1, p2;
+			//Linear voxel indices have the same order as the lattice cells
+			lattice.classifyEdge(edges, edgeIndex, voxelResults.data());
 
-			GeometryOps::buildEdgeTrianglePlane(edge.first, edge.second[0], p1);
-			GeometryOps::buildEdgeTrianglePlane(edge.first, edge.second[1], p2);
-
-			const unsigned int numVoxels = _voxelizedSpace.getNumVoxels();
 			for (unsigned int i = 0; i < numVoxels; ++i)
 			{
-				AABB voxel;
-				_voxelizedSpace.getVoxelFromLinearIndex(i, voxel);
+				const EdgeSilhouetness result = voxelResults[i];
+				edgeTests.add(result);
 
-				int result = int(GeometryOps::testEdgeSpaceAabb(p1, p2, edge, voxel));
+				if (EDGE_IS_SILHOUETTE(result))
+					++numVoxelSilhouette[i];
+				else if (result == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+					++numVoxelPotential[i];
 
-				ma.setCellContent(i, result);
+				MultiBitArray::setCellContent(edgeBitmask, _numBitsPerCell, i, uint32_t(result));
 			}
 		}
+	}
+
+	_edgeBitmasks.assign(std::move(edgeBitmasks));
+
+	classifyPhase.stop();
+
+	_buildReport.setMethod("bitArrayVoxels");
+	_buildReport.addParameter("numEdges", double(edges.size()));
+	_buildReport.addParameter("numVoxelsX", params->numVoxelsX);
+	_buildReport.addParameter("numVoxelsY", params->numVoxelsY);
+	_buildReport.addParameter("numVoxelsZ", params->numVoxelsZ);
+	_buildReport.addEdgeTests(edgeTests);
 
-		edgeIndex++;
+	//The grid is reported as a single level
+	BuildReport::LevelStats level;
+	level.numNodes = level.numStoredNodes = numVoxels;
+	level.numBytes = _edgeBitmasks.getSizeBytes();
 
-		_edgeBitmasks.push_back(ma);
+	for (unsigned int i = 0; i < numVoxels; ++i)
+	{
+		level.numPotentialEdges += numVoxelPotential[i] + numOpenEdges;
+		level.numSilhouetteEdges += numVoxelSilhouette[i];
+
+		BuildReport::addToHistogram(level.potentialHistogram, numVoxelPotential[i] + numOpenEdges);
+		BuildReport::addToHistogram(level.silhouetteHistogram, numVoxelSilhouette[i]);
 	}
+
+	_buildReport.addLevel(level);
+	_buildReport.setStructureSizeBytes(getAccelerationStructureSizeBytes());
 }
 
 void BitArrayVoxelSilhouettes::clear()
 {
 	_edgeBitmasks.clear();
+	_cacheFile.reset();
+	_buildReport.clear();
+
+	_arraySizePerEdge = _numBitsPerCell = _numEdges = 0;
+}
+
+StructureCacheKey BitArrayVoxelSilhouettes::_getCacheKey(const EdgeStore& edges, const AABB& lightSpace, const VoxelParams* params)
+{
+	CacheHasher paramsHasher;
+	paramsHasher.addValue(uint32_t(params->numVoxelsX));
+	paramsHasher.addValue(uint32_t(params->numVoxelsY));
+	paramsHasher.addValue(uint32_t(params->numVoxelsZ));
+
+	StructureCacheKey key;
+	key.methodType = uint32_t(SilhouetteMethodType::BIT_ARRAY_VOXELS);
+	key.edgesHash = CacheHasher::hashEdges(edges);
+	key.lightSpaceHash = CacheHasher::hashAabb(lightSpace);
+	key.paramsHash = paramsHasher.getHash();
+
+	return key;
+}
+
+bool BitArrayVoxelSilhouettes::save(const std::string& path) const
+{
+	if (_edgeBitmasks.empty())
+		return false;
+
+	const uint32_t layout[3] = { _arraySizePerEdge, _numBitsPerCell, _numEdges };
+
+	StructureCacheWriter writer(_cacheKey);
+	writer.writeArray(layout, 3);
+	writer.writeArray(_edgeBitmasks.data(), _edgeBitmasks.size());
+
+	return writer.saveToFile(path);
+}
+
+bool BitArrayVoxelSilhouettes::load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams)
+{
+	clear();
+
+	const auto params = reinterpret_cast<VoxelParams*>(customParams);
+	const StructureCacheKey key = _getCacheKey(edges, lightSpace, params);
+
+	StructureCacheReader reader;
+	if (!reader.open(path, key))
+		return false;
+
+	const uint32_t* layout = nullptr;
+	const uint32_t* edgeBitmasks = nullptr;
+	size_t layoutSize = 0, numItems = 0;
+
+	if (!reader.readArray(layout, layoutSize) || layoutSize != 3 || !reader.readArray(edgeBitmasks, numItems))
+		return false;
+
+	if (numItems != uint64_t(layout[0]) * layout[2])
+		return false;
+
+	//Cells of every voxel have to fit in the array of an edge
+	const uint64_t numVoxels = uint64_t(params->numVoxelsX) * params->numVoxelsY * params->numVoxelsZ;
+	if (layout[1] == 0 || layout[1] >= MBA_MAX_BITS_PER_CELL || uint64_t(layout[1]) * numVoxels > uint64_t(layout[0]) * MBA_ARRAY_ITEM_SIZE)
+		return false;
+
+	_voxelizedSpace.init(lightSpace, params->numVoxelsX, params->numVoxelsY, params->numVoxelsZ);
+
+	_arraySizePerEdge = layout[0];
+	_numBitsPerCell = layout[1];
+	_numEdges = layout[2];
+	_edgeBitmasks.reference(edgeBitmasks, numItems);
+
+	_cacheKey = key;
+	_cacheFile = reader.getMappedFile();
+
+	return true;
 }
 
 void BitArrayVoxelSilhouettes::getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices)
 {
-	AABB voxel;
-	const int voxelIndex = _getVoxelIndexAABBFromPos(lightPos, voxel);
-	
-	std::cout << "Voxel index: " << voxelIndex << "\n";
-	auto minP = voxel.getMinPoint();
-	auto maxP = voxel.getMaxPoint();
-	std::cout << "Voxel space " << minP.x << ", " << minP.y << ", " << minP.z << " Max: " << maxP.x << ", " << maxP.y << ", " << maxP.z << "\n";
-	minP = voxel.getCenterPoint();
-	voxel.getExtents(maxP.x, maxP.y, maxP.z);
-	std::cout << "Center " << minP.x << ", " << minP.y << ", " << minP.z << " Extents: " << maxP.x << ", " << maxP.y << ", " << maxP.z << "\n";
+	SilhouetteEdgeCollector collector(potentialEdgeIndices, silhouetteEdgeIndices);
+	visitSilhouetteEdgesForLightPos(lightPos, collector);
+}
+
+int BitArrayVoxelSilhouettes::_getLightGroupKey(const glm::vec3& lightPos) const
+{
+	//Lights within one voxel share the scan over all edges
+	return _voxelizedSpace.getVoxelLinearIndexFromPointInSpace(lightPos);
+}
+
+void BitArrayVoxelSilhouettes::visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const
+{
+	const int voxelIndex = _voxelizedSpace.getVoxelLinearIndexFromPointInSpace(lightPos);
 
 	if (voxelIndex < 0)
 		return;
 
-	int edgeIndex = 0;
-	for(const auto _edgeEntry : _edgeBitmasks)
+	//Results are gathered in fixed-size chunks, so that visiting never allocates
+	unsigned int potential[VOXEL_SILHOUETTES_CHUNK_SIZE];
+	int silhouette[VOXEL_SILHOUETTES_CHUNK_SIZE];
+	unsigned int numPotential = 0;
+	unsigned int numSilhouette = 0;
+
+	for(unsigned int edgeIndex = 0; edgeIndex < _numEdges; ++edgeIndex)
 	{
-		int result = _edgeEntry.getCellContent(voxelIndex);
+		const int result = MultiBitArray::getCellContent(_edgeBitmasks.data() + uint64_t(edgeIndex) * _arraySizePerEdge, _numBitsPerCell, voxelIndex);
 
 		if (EDGE_IS_SILHOUETTE(result))
 		{
 			const int multiplicitySign = (result == int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS)) + (-1)*(result == int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS));
-			silhouetteEdgeIndices.push_back(multiplicitySign * edgeIndex);
+			silhouette[numSilhouette++] = encodeSilhouetteEdge(edgeIndex, multiplicitySign);
+
+			if (numSilhouette == VOXEL_SILHOUETTES_CHUNK_SIZE)
+			{
+				visitor.visitSilhouetteEdges(silhouette, silhouette + numSilhouette);
+				numSilhouette = 0;
+			}
 		}
 
 		if (result == int(EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE))
-			potentialEdgeIndices.push_back(edgeIndex);
+		{
+			potential[numPotential++] = edgeIndex;
 
-		++edgeIndex;
+			if (numPotential == VOXEL_SILHOUETTES_CHUNK_SIZE)
+			{
+				visitor.visitPotentialEdges(potential, potential + numPotential);
+				numPotential = 0;
+			}
+		}
 	}
-}
-
-int BitArrayVoxelSilhouettes::_getVoxelIndexAABBFromPos(const glm::vec3& lightPos, AABB& bbox) const
-{
-	const int voxelIndex = _voxelizedSpace.getVoxelLinearIndexFromPointInSpace(lightPos);
 
-	if (voxelIndex < 0)
-	{
-		std::cerr << "Invalid light position with respect to voxelized space\n";
-		bbox = AABB();
+	if (numSilhouette)
+		visitor.visitSilhouetteEdges(silhouette, silhouette + numSilhouette);
 
-		return -1;
-	}
-
-	_voxelizedSpace.getVoxelFromLinearIndex(voxelIndex, bbox);
-	
-	return voxelIndex;
+	if (numPotential)
+		visitor.visitPotentialEdges(potential, potential + numPotential);
 }
 
 uint64_t BitArrayVoxelSilhouettes::getAccelerationStructureSizeBytes() const
 {
-	return _edgeBitmasks.size() * _edgeBitmasks[0].getNumCells() * (MBA_MAX_BITS_PER_CELL / 8);
+	return _edgeBitmasks.getSizeBytes();
 }
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 
 #include "AbstractSilhouetteMethod.hpp"
 #include "MultiBitArray.hpp"
 #include "VoxelSpace.hpp"
-#include "Edge.hpp"
+#include "PackedArray.hpp"
+#include "StructureCache.hpp"
+#include "EdgeStore.hpp"
 
 struct VoxelParams
 {
@@ -19,24 +22,36 @@ public:
 	BitArrayVoxelSilhouettes();
 	~BitArrayVoxelSilhouettes();
 
-	void initialize(const EDGE_CONTAINER_TYPE& edges, const AABB& lightSpace, void* customParams) override;
+	void initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
 
 	void clear() override;
 
 	void getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices) override;
+	void visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const override;
 
 	uint64_t getAccelerationStructureSizeBytes() const override;
 
-	std::vector<MultiBitArray>* getEdgeBitArrays()
-	{
-		return &_edgeBitmasks;
-	}
+	bool save(const std::string& path) const override;
+	bool load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
+protected:
+
+	int _getLightGroupKey(const glm::vec3& lightPos) const override;
 
 private:
 
 	void _initVoxelization();
-	int  _getVoxelIndexAABBFromPos(const glm::vec3& lightPos, AABB& bbox) const;
 
-	std::vector<MultiBitArray>	_edgeBitmasks;
+	static StructureCacheKey _getCacheKey(const EdgeStore& edges, const AABB& lightSpace, const VoxelParams* params);
+
+	//Bit arrays of all edges stored one after another, each _arraySizePerEdge items long
+	PackedArray<uint32_t>		_edgeBitmasks;
+	unsigned int				_arraySizePerEdge;
+	unsigned int				_numBitsPerCell;
+	unsigned int				_numEdges;
+
 	VoxelizedSpace				_voxelizedSpace;
+
+	StructureCacheKey			_cacheKey;
+	std::shared_ptr<MappedFile>	_cacheFile;
 };
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 inline void SetBit(uint32_t& bitField, unsigned int bit)
 {
     bitField |= 1 << bit;
@@ -25,3 +31,24 @@ inline void FlipBit(uint32_t& bitfield, unsigned int bit)
 	else
 		SetBit(bitfield, bit);
 }
+
+//Index of the most significant set bit, value must not be 0
+inline unsigned int GetHighestSetBit(uint64_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+inline unsigned int CountSetBits(uint32_t value)
+{
+#ifdef _MSC_VER
+	return __popcnt(value);
+#else
+	return __builtin_popcount(value);
+#endif
+}
@@ -0,0 +1,46 @@
+#include "BruteForceSilhouettes.hpp"
+
+#include <numeric>
+
+void BruteForceSilhouettes::initialize(const EdgeStore& edges, const AABB& /*lightSpace*/, void* /*customParams*/)
+{
+	clear();
+
+	_edgeIDs.resize(edges.size());
+	std::iota(_edgeIDs.begin(), _edgeIDs.end(), 0);
+
+	_buildReport.setMethod("bruteForce");
+	_buildReport.addParameter("numEdges", double(edges.size()));
+}
+
+void BruteForceSilhouettes::getSilhouetteEdgesForLightPos(const glm::vec3& /*lightPos*/, std::vector<int>& potentialEdgeIndices, std::vector<int>& /*silhouetteEdgeIndices*/)
+{
+	potentialEdgeIndices.insert(potentialEdgeIndices.end(), _edgeIDs.begin(), _edgeIDs.end());
+}
+
+void BruteForceSilhouettes::visitSilhouetteEdgesForLightPos(const glm::vec3& /*lightPos*/, SilhouetteEdgeVisitor& visitor) const
+{
+	if (!_edgeIDs.empty())
+		visitor.visitPotentialEdges(_edgeIDs.data(), _edgeIDs.data() + _edgeIDs.size());
+}
+
+void BruteForceSilhouettes::clear()
+{
+	_edgeIDs.clear();
+	_buildReport.clear();
+}
+
+uint64_t BruteForceSilhouettes::getAccelerationStructureSizeBytes() const
+{
+	return _edgeIDs.size() * sizeof(unsigned int);
+}
+
+bool BruteForceSilhouettes::save(const std::string& /*path*/) const
+{
+	return false;
+}
+
+bool BruteForceSilhouettes::load(const std::string& /*path*/, const EdgeStore& /*edges*/, const AABB& /*lightSpace*/, void* /*customParams*/)
+{
+	return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "AbstractSilhouetteMethod.hpp"
+
+//No acceleration structure, every edge is reported as potentially silhouette from everywhere
+//Needs no build, so it can answer queries while a real structure is being built
+class BruteForceSilhouettes : public AbstractSilhouetteMethod
+{
+public:
+	void getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices) override;
+	void visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const override;
+
+	//Custom params are not used
+	void initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
+	void clear() override;
+
+	uint64_t getAccelerationStructureSizeBytes() const override;
+
+	//There is nothing worth caching
+	bool save(const std::string& path) const override;
+	bool load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
+private:
+
+	std::vector<unsigned int> _edgeIDs;
+};
@@ -0,0 +1,80 @@
+#include "BuildArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+static thread_local BuildArena* currentArena = nullptr;
+
+BuildArena::Scope::Scope(BuildArena& arena)
+{
+	_previous = currentArena;
+	currentArena = &arena;
+}
+
+BuildArena::Scope::~Scope()
+{
+	currentArena = _previous;
+}
+
+BuildArena::BuildArena() : _currentBlock(0), _currentOffset(0)
+{
+}
+
+void* BuildArena::allocate(size_t numBytes, size_t alignment)
+{
+	while (_currentBlock < _blocks.size())
+	{
+		const Block& block = _blocks[_currentBlock];
+		const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		const size_t offset = ((base + _currentOffset + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+
+		if (offset + numBytes <= block.size)
+		{
+			_currentOffset = offset + numBytes;
+			return block.memory.get() + offset;
+		}
+
+		++_currentBlock;
+		_currentOffset = 0;
+	}
+
+	//Larger requests get a block of their own
+	Block block;
+	block.size = std::max(size_t(BUILD_ARENA_BLOCK_SIZE), numBytes + alignment);
+	block.memory.reset(new unsigned char[block.size]);
+	_blocks.push_back(std::move(block));
+
+	_currentBlock = _blocks.size() - 1;
+	_currentOffset = 0;
+
+	return allocate(numBytes, alignment);
+}
+
+void BuildArena::reset()
+{
+	_currentBlock = 0;
+	_currentOffset = 0;
+}
+
+void BuildArena::release()
+{
+	_blocks.clear();
+	reset();
+}
+
+size_t BuildArena::getNumReservedBytes() const
+{
+	size_t numBytes = 0;
+	for (const auto& block : _blocks)
+		numBytes += block.size;
+
+	return numBytes;
+}
+
+BuildArena* BuildArena::getCurrent()
+{
+	assert(currentArena != nullptr);
+
+	return currentArena;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#define BUILD_ARENA_BLOCK_SIZE (1 << 20)
+
+//Bump allocator for the temporary lists of a build, memory is never freed one allocation at a time
+//Each build worker owns one, so allocating takes no lock
+class BuildArena
+{
+public:
+	//Makes default constructed BuildArenaAllocators on the current thread allocate from the arena
+	class Scope
+	{
+	public:
+		Scope(BuildArena& arena);
+		~Scope();
+
+	private:
+		BuildArena* _previous;
+	};
+
+	BuildArena();
+
+	void* allocate(size_t numBytes, size_t alignment);
+
+	//Allocations become invalid, the blocks are kept for reuse
+	void reset();
+	//Frees all blocks
+	void release();
+
+	size_t getNumReservedBytes() const;
+
+	static BuildArena* getCurrent();
+
+private:
+	struct Block
+	{
+		std::unique_ptr<unsigned char[]>	memory;
+		size_t								size;
+	};
+
+	std::vector<Block>	_blocks;
+	size_t				_currentBlock;
+	size_t				_currentOffset;
+};
+
+template<typename T>
+class BuildArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	BuildArenaAllocator() : _arena(BuildArena::getCurrent()) {}
+	BuildArenaAllocator(BuildArena& arena) : _arena(&arena) {}
+
+	template<typename U>
+	BuildArenaAllocator(const BuildArenaAllocator<U>& other) : _arena(other._arena) {}
+
+	T* allocate(size_t n)
+	{
+		return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	template<typename U>
+	bool operator==(const BuildArenaAllocator<U>& other) const { return _arena == other._arena; }
+
+	template<typename U>
+	bool operator!=(const BuildArenaAllocator<U>& other) const { return _arena != other._arena; }
+
+private:
+	template<typename U> friend class BuildArenaAllocator;
+
+	BuildArena* _arena;
+};
+
+template<typename T>
+using BuildArenaVector = std::vector<T, BuildArenaAllocator<T> >;
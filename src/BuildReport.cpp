@@ -0,0 +1,179 @@
+#include "BuildReport.hpp"
+
+#include <fstream>
+#include <sstream>
+
+void EdgeTestCounters::clear()
+{
+	for (auto& count : counts)
+		count = 0;
+}
+
+uint64_t EdgeTestCounters::getNumTests() const
+{
+	return counts[0] + counts[1] + counts[2] + counts[3];
+}
+
+BuildReport::PhaseTimer::PhaseTimer(BuildReport& report, const std::string& name) : _report(report), _name(name), _isStopped(false)
+{
+	_wallStart = std::chrono::steady_clock::now();
+	_cpuStart = std::clock();
+}
+
+BuildReport::PhaseTimer::~PhaseTimer()
+{
+	stop();
+}
+
+double BuildReport::PhaseTimer::stop()
+{
+	const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _wallStart).count();
+
+	if (!_isStopped)
+	{
+		//Process time, includes all build workers
+		const double cpuSeconds = double(std::clock() - _cpuStart) / CLOCKS_PER_SEC;
+		_report.addPhase(_name, wallSeconds, cpuSeconds);
+		_isStopped = true;
+	}
+
+	return wallSeconds;
+}
+
+BuildReport::BuildReport()
+{
+	clear();
+}
+
+void BuildReport::clear()
+{
+	_method.clear();
+	_parameters.clear();
+	_phases.clear();
+	_edgeTests.clear();
+	_levels.clear();
+	_structureSizeBytes = 0;
+}
+
+void BuildReport::setMethod(const std::string& method)
+{
+	_method = method;
+}
+
+void BuildReport::addParameter(const std::string& name, double value)
+{
+	_parameters.push_back(std::make_pair(name, value));
+}
+
+void BuildReport::addPhase(const std::string& name, double wallSeconds, double cpuSeconds)
+{
+	_phases.push_back({ name, wallSeconds, cpuSeconds });
+}
+
+void BuildReport::addEdgeTests(const EdgeTestCounters& counters)
+{
+	for (unsigned int i = 0; i < 4; ++i)
+		_edgeTests.counts[i] += counters.counts[i];
+}
+
+void BuildReport::addLevel(const LevelStats& level)
+{
+	_levels.push_back(level);
+}
+
+void BuildReport::clearLevels()
+{
+	_levels.clear();
+}
+
+void BuildReport::setStructureSizeBytes(uint64_t numBytes)
+{
+	_structureSizeBytes = numBytes;
+}
+
+void BuildReport::addToHistogram(std::vector<uint64_t>& histogram, uint64_t listLength)
+{
+	unsigned int bucket = 0;
+	while (listLength)
+	{
+		++bucket;
+		listLength >>= 1;
+	}
+
+	if (histogram.size() <= bucket)
+		histogram.resize(bucket + 1, 0);
+
+	++histogram[bucket];
+}
+
+bool BuildReport::isEmpty() const
+{
+	return _phases.empty() && _levels.empty();
+}
+
+void BuildReport::_writeHistogram(std::ostream& stream, const std::vector<uint64_t>& histogram)
+{
+	stream << "[";
+	for (size_t i = 0; i < histogram.size(); ++i)
+		stream << (i ? ", " : "") << histogram[i];
+	stream << "]";
+}
+
+void BuildReport::writeJson(std::ostream& stream) const
+{
+	//Names are identifiers chosen by the build code, nothing needs escaping
+	stream << "{\n";
+	stream << "\t\"method\": \"" << _method << "\",\n";
+
+	stream << "\t\"parameters\": {";
+	for (size_t i = 0; i < _parameters.size(); ++i)
+		stream << (i ? ", " : "") << "\"" << _parameters[i].first << "\": " << _parameters[i].second;
+	stream << "},\n";
+
+	stream << "\t\"phases\": [";
+	for (size_t i = 0; i < _phases.size(); ++i)
+		stream << (i ? "," : "") << "\n\t\t{\"name\": \"" << _phases[i].name << "\", \"wallSeconds\": " << _phases[i].wallSeconds << ", \"cpuSeconds\": " << _phases[i].cpuSeconds << "}";
+	stream << (_phases.empty() ? "" : "\n\t") << "],\n";
+
+	stream << "\t\"edgeTests\": {\"total\": " << _edgeTests.getNumTests()
+		<< ", \"notSilhouette\": " << _edgeTests.counts[int(EdgeSilhouetness::EDGE_NOT_SILHOUETTE)]
+		<< ", \"potentiallySilhouette\": " << _edgeTests.counts[int(EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)]
+		<< ", \"silhouettePlus\": " << _edgeTests.counts[int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS)]
+		<< ", \"silhouetteMinus\": " << _edgeTests.counts[int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS)] << "},\n";
+
+	stream << "\t\"levels\": [";
+	for (size_t i = 0; i < _levels.size(); ++i)
+	{
+		const LevelStats& level = _levels[i];
+
+		stream << (i ? "," : "") << "\n\t\t{\"level\": " << level.level << ", \"nodes\": " << level.numNodes << ", \"storedNodes\": " << level.numStoredNodes << ", \"bytes\": " << level.numBytes
+			<< ", \"potentialEdges\": " << level.numPotentialEdges << ", \"silhouetteEdges\": " << level.numSilhouetteEdges << ", \"potentialHistogram\": ";
+		_writeHistogram(stream, level.potentialHistogram);
+		stream << ", \"silhouetteHistogram\": ";
+		_writeHistogram(stream, level.silhouetteHistogram);
+		stream << "}";
+	}
+	stream << (_levels.empty() ? "" : "\n\t") << "],\n";
+
+	stream << "\t\"structureSizeBytes\": " << _structureSizeBytes << "\n";
+	stream << "}\n";
+}
+
+std::string BuildReport::toJson() const
+{
+	std::stringstream stream;
+	writeJson(stream);
+
+	return stream.str();
+}
+
+bool BuildReport::saveJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	writeJson(file);
+
+	return bool(file);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GeometryOperations.hpp"
+
+//Outcomes of testEdgeSpaceAabb calls made by one thread, merged into the report once the thread is done
+struct EdgeTestCounters
+{
+	EdgeTestCounters() { clear(); }
+
+	void add(EdgeSilhouetness result) { ++counts[int(result)]; }
+	void clear();
+
+	uint64_t getNumTests() const;
+
+	uint64_t counts[4];
+
+	//Counters of different workers stay in different cache lines
+	uint64_t padding[4];
+};
+
+//Machine-readable statistics of one acceleration structure build
+class BuildReport
+{
+public:
+	//Histograms bucket by powers of two, bucket 0 holds empty lists, bucket i lengths [2^(i-1), 2^i)
+	struct LevelStats
+	{
+		LevelStats() : level(0), numNodes(0), numStoredNodes(0), numBytes(0), numPotentialEdges(0), numSilhouetteEdges(0) {}
+
+		unsigned int			level;
+		uint64_t				numNodes;
+		//Nodes left after merging identical subtrees
+		uint64_t				numStoredNodes;
+		uint64_t				numBytes;
+
+		uint64_t				numPotentialEdges;
+		uint64_t				numSilhouetteEdges;
+		std::vector<uint64_t>	potentialHistogram;
+		std::vector<uint64_t>	silhouetteHistogram;
+	};
+
+	//Measures wall and process CPU time of a phase from its construction
+	class PhaseTimer
+	{
+	public:
+		PhaseTimer(BuildReport& report, const std::string& name);
+		~PhaseTimer();
+
+		//Adds the phase to the report, returns its wall time in seconds
+		double stop();
+
+	private:
+		BuildReport&							_report;
+		std::string								_name;
+		std::chrono::steady_clock::time_point	_wallStart;
+		std::clock_t							_cpuStart;
+		bool									_isStopped;
+	};
+
+	BuildReport();
+
+	void clear();
+
+	void setMethod(const std::string& method);
+	void addParameter(const std::string& name, double value);
+
+	void addPhase(const std::string& name, double wallSeconds, double cpuSeconds);
+	void addEdgeTests(const EdgeTestCounters& counters);
+	void addLevel(const LevelStats& level);
+	void clearLevels();
+	void setStructureSizeBytes(uint64_t numBytes);
+
+	static void addToHistogram(std::vector<uint64_t>& histogram, uint64_t listLength);
+
+	bool isEmpty() const;
+
+	void writeJson(std::ostream& stream) const;
+	std::string toJson() const;
+	bool saveJson(const std::string& path) const;
+
+private:
+	struct Phase
+	{
+		std::string	name;
+		double		wallSeconds;
+		double		cpuSeconds;
+	};
+
+	static void _writeHistogram(std::ostream& stream, const std::vector<uint64_t>& histogram);
+
+	std::string									_method;
+	std::vector< std::pair<std::string, double> >	_parameters;
+	std::vector<Phase>							_phases;
+	EdgeTestCounters							_edgeTests;
+	std::vector<LevelStats>						_levels;
+	uint64_t									_structureSizeBytes;
+};
@@ -0,0 +1,285 @@
+#include "BuildThreadPool.hpp"
+
+#include <algorithm>
+
+//Failed attempts to find a task before a worker goes to sleep
+#define BUILD_THREAD_POOL_SPIN_COUNT 64
+
+static thread_local const BuildThreadPool* currentPool = nullptr;
+static thread_local unsigned int currentWorkerIndex = 0;
+
+//Time spent in nested waits without any task to run is not counted as busy
+static thread_local unsigned int taskDepth = 0;
+static thread_local uint64_t nestedIdleNanoseconds = 0;
+
+static uint64_t getNanosecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+BuildThreadPool::TaskGroup::TaskGroup(BuildThreadPool& pool) : _pool(pool), _numPending(0)
+{
+}
+
+BuildThreadPool::TaskGroup::~TaskGroup()
+{
+	wait();
+}
+
+void BuildThreadPool::TaskGroup::run(const std::function<void()>& task)
+{
+	++_numPending;
+	_pool._pushTask({ task, this });
+}
+
+void BuildThreadPool::TaskGroup::wait()
+{
+	if (currentPool != &_pool)
+	{
+		std::unique_lock<std::mutex> lock(_pool._groupMutex);
+		_pool._groupFinished.wait(lock, [this]() { return _numPending == 0; });
+		return;
+	}
+
+	//Blocking a worker could deadlock on tasks queued behind it, so it helps instead
+	while (_numPending > 0)
+	{
+		Task task;
+		if (_pool._popTask(currentWorkerIndex, task))
+			_pool._executeTask(task);
+		else
+		{
+			const auto start = std::chrono::steady_clock::now();
+			std::this_thread::yield();
+			nestedIdleNanoseconds += getNanosecondsSince(start);
+		}
+	}
+}
+
+BuildThreadPool::BuildThreadPool(unsigned int numWorkers) : _stop(false), _numQueuedTasks(0), _nextExternalWorker(0)
+{
+	if (numWorkers == 0)
+		numWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < numWorkers; ++i)
+	{
+		_workers.push_back(std::unique_ptr<Worker>(new Worker));
+		_workers.back()->busyNanoseconds = 0;
+		_workers.back()->numTasks = 0;
+		_workers.back()->numStolenTasks = 0;
+	}
+
+	resetWorkerStats();
+
+	for (unsigned int i = 0; i < numWorkers; ++i)
+		_workers[i]->thread = std::thread(&BuildThreadPool::_workerLoop, this, i);
+}
+
+BuildThreadPool::~BuildThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_stop = true;
+	}
+	_workAvailable.notify_all();
+
+	for (auto& worker : _workers)
+		worker->thread.join();
+}
+
+std::shared_ptr<BuildThreadPool> BuildThreadPool::getShared()
+{
+	static std::mutex sharedMutex;
+	static std::weak_ptr<BuildThreadPool> sharedPool;
+
+	std::lock_guard<std::mutex> lock(sharedMutex);
+
+	std::shared_ptr<BuildThreadPool> pool = sharedPool.lock();
+	if (!pool)
+	{
+		pool = std::make_shared<BuildThreadPool>();
+		sharedPool = pool;
+	}
+
+	return pool;
+}
+
+unsigned int BuildThreadPool::getNumWorkers() const
+{
+	return static_cast<unsigned int>(_workers.size());
+}
+
+unsigned int BuildThreadPool::getCurrentWorkerIndex() const
+{
+	return currentPool == this ? currentWorkerIndex : getNumWorkers();
+}
+
+void BuildThreadPool::parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+	if (end <= begin)
+		return;
+
+	grainSize = std::max(grainSize, 1);
+
+	TaskGroup group(*this);
+
+	if (currentPool == this)
+		_runRange(group, begin, end, grainSize, body);
+	else
+		group.run([this, &group, begin, end, grainSize, &body]() { _runRange(group, begin, end, grainSize, body); });
+
+	group.wait();
+}
+
+void BuildThreadPool::_runRange(TaskGroup& group, int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+	//The upper halves are left for thieves, the owner continues with ever smaller lower halves
+	while (end - begin > grainSize)
+	{
+		const int middle = begin + (end - begin) / 2;
+		group.run([this, &group, middle, end, grainSize, &body]() { _runRange(group, middle, end, grainSize, body); });
+		end = middle;
+	}
+
+	body(begin, end);
+}
+
+void BuildThreadPool::getWorkerStats(std::vector<WorkerStats>& stats) const
+{
+	const double elapsedSeconds = getNanosecondsSince(_statsResetTime) / 1e9;
+
+	stats.resize(_workers.size());
+
+	for (size_t i = 0; i < _workers.size(); ++i)
+	{
+		stats[i].busySeconds = _workers[i]->busyNanoseconds / 1e9;
+		stats[i].idleSeconds = std::max(0.0, elapsedSeconds - stats[i].busySeconds);
+		stats[i].numTasks = _workers[i]->numTasks;
+		stats[i].numStolenTasks = _workers[i]->numStolenTasks;
+	}
+}
+
+void BuildThreadPool::resetWorkerStats()
+{
+	for (auto& worker : _workers)
+	{
+		worker->busyNanoseconds = 0;
+		worker->numTasks = 0;
+		worker->numStolenTasks = 0;
+	}
+
+	_statsResetTime = std::chrono::steady_clock::now();
+}
+
+void BuildThreadPool::_workerLoop(unsigned int workerIndex)
+{
+	currentPool = this;
+	currentWorkerIndex = workerIndex;
+
+	unsigned int numFailedAttempts = 0;
+
+	while (!_stop)
+	{
+		Task task;
+		if (_popTask(workerIndex, task))
+		{
+			_executeTask(task);
+			numFailedAttempts = 0;
+			continue;
+		}
+
+		if (++numFailedAttempts < BUILD_THREAD_POOL_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		//Pushes count their tasks under the same mutex, so none can be missed between the check and the wait
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_workAvailable.wait(lock, [this]() { return _stop || _numQueuedTasks > 0; });
+		numFailedAttempts = 0;
+	}
+}
+
+void BuildThreadPool::_pushTask(const Task& task)
+{
+	const unsigned int workerIndex = currentPool == this ? currentWorkerIndex : (_nextExternalWorker++ % getNumWorkers());
+	Worker& worker = *_workers[workerIndex];
+
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.tasks.push_back(task);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		++_numQueuedTasks;
+	}
+	_workAvailable.notify_one();
+}
+
+bool BuildThreadPool::_popTask(unsigned int workerIndex, Task& task)
+{
+	if (_numQueuedTasks <= 0)
+		return false;
+
+	{
+		Worker& worker = *_workers[workerIndex];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+
+		if (!worker.tasks.empty())
+		{
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			--_numQueuedTasks;
+			return true;
+		}
+	}
+
+	const unsigned int numWorkers = getNumWorkers();
+
+	for (unsigned int i = 1; i < numWorkers; ++i)
+	{
+		Worker& victim = *_workers[(workerIndex + i) % numWorkers];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			--_numQueuedTasks;
+			++_workers[workerIndex]->numStolenTasks;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void BuildThreadPool::_executeTask(Task& task)
+{
+	Worker& worker = *_workers[currentWorkerIndex];
+
+	const bool isOutermost = taskDepth == 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	++taskDepth;
+	task.function();
+	--taskDepth;
+
+	if (isOutermost)
+	{
+		const uint64_t elapsed = getNanosecondsSince(start);
+		worker.busyNanoseconds += elapsed - std::min(elapsed, nestedIdleNanoseconds);
+		nestedIdleNanoseconds = 0;
+	}
+
+	++worker.numTasks;
+
+	//The group may be destroyed as soon as the counter reaches zero
+	if (task.group->_numPending.fetch_sub(1) == 1)
+	{
+		std::lock_guard<std::mutex> lock(_groupMutex);
+		_groupFinished.notify_all();
+	}
+}
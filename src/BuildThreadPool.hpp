@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Work-stealing thread pool for the acceleration structure builds, does not depend on OpenMP
+//Workers take tasks from the back of their own deque and steal from the front of the others,
+//so thieves get the oldest, largest halves of split ranges
+class BuildThreadPool
+{
+public:
+	struct WorkerStats
+	{
+		double		busySeconds;
+		double		idleSeconds;
+		uint64_t	numTasks;
+		uint64_t	numStolenTasks;
+	};
+
+	//Tasks run through the same group are waited for together, groups can be nested inside tasks
+	class TaskGroup
+	{
+	public:
+		TaskGroup(BuildThreadPool& pool);
+		~TaskGroup();
+
+		void run(const std::function<void()>& task);
+
+		//Workers keep executing other tasks while waiting, other threads block
+		void wait();
+
+	private:
+		friend class BuildThreadPool;
+
+		BuildThreadPool&	_pool;
+		std::atomic<int>	_numPending;
+	};
+
+	//0 creates one worker per hardware thread
+	BuildThreadPool(unsigned int numWorkers = 0);
+	~BuildThreadPool();
+
+	//Pool with one worker per hardware thread shared by all builds, created on first use and destroyed with its last holder
+	//Builds running at the same time share its worker stats
+	static std::shared_ptr<BuildThreadPool> getShared();
+
+	unsigned int getNumWorkers() const;
+
+	//Threads outside of the pool get getNumWorkers(), per-thread buffers need getNumWorkers() + 1 slots
+	unsigned int getCurrentWorkerIndex() const;
+
+	//Calls body with disjoint subranges of [begin, end) no longer than grainSize
+	void parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+	//Time since the last reset
+	void getWorkerStats(std::vector<WorkerStats>& stats) const;
+	void resetWorkerStats();
+
+private:
+	struct Task
+	{
+		std::function<void()>	function;
+		TaskGroup*				group;
+	};
+
+	struct Worker
+	{
+		std::thread				thread;
+		std::mutex				mutex;
+		std::deque<Task>		tasks;
+
+		std::atomic<uint64_t>	busyNanoseconds;
+		std::atomic<uint64_t>	numTasks;
+		std::atomic<uint64_t>	numStolenTasks;
+	};
+
+	void _workerLoop(unsigned int workerIndex);
+
+	void _pushTask(const Task& task);
+	bool _popTask(unsigned int workerIndex, Task& task);
+	void _executeTask(Task& task);
+
+	void _runRange(TaskGroup& group, int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+	std::vector< std::unique_ptr<Worker> >	_workers;
+
+	std::atomic<bool>						_stop;
+	std::atomic<int>						_numQueuedTasks;
+	std::atomic<unsigned int>				_nextExternalWorker;
+
+	std::mutex								_sleepMutex;
+	std::condition_variable					_workAvailable;
+
+	std::mutex								_groupMutex;
+	std::condition_variable					_groupFinished;
+
+	std::chrono::steady_clock::time_point	_statsResetTime;
+};
@@ -2,8 +2,22 @@
 
 #include <glm/glm.hpp>
 
-#define EDGE_TYPE std::pair<Edge, std::vector<glm::vec4>>
-#define EDGE_CONTAINER_TYPE std::vector<EDGE_TYPE>
+//Silhouette edges carry the sign of their multiplicity
+//Negative ones are stored bitwise negated, so that edge 0 can be negative as well
+inline int encodeSilhouetteEdge(unsigned int edgeID, int multiplicitySign)
+{
+	return multiplicitySign < 0 ? ~int(edgeID) : int(edgeID);
+}
+
+inline unsigned int decodeSilhouetteEdgeID(int silhouetteEdge)
+{
+	return silhouetteEdge < 0 ? ~silhouetteEdge : silhouetteEdge;
+}
+
+inline int decodeSilhouetteEdgeSign(int silhouetteEdge)
+{
+	return silhouetteEdge < 0 ? -1 : 1;
+}
 
 struct Edge
 {
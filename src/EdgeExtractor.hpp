@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Triangle.hpp"
-#include "Edge.hpp"
+#include "EdgeStore.hpp"
 
 #include <vector>
 #include <map>
@@ -10,5 +10,5 @@ class EdgeExtractor
 {
 public:
 
-	void extractEdgesFromTriangles(const std::vector<Triangle>& triangles, EDGE_CONTAINER_TYPE& edges) const;
+	void extractEdgesFromTriangles(const std::vector<Triangle>& triangles, EdgeStore& edges) const;
 };
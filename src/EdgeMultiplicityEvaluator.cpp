@@ -0,0 +1,205 @@
+#include "EdgeMultiplicityEvaluator.hpp"
+#include "GeometryOperations.hpp"
+
+#ifdef EDGE_MULTIPLICITY_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define EDGE_MULTIPLICITY_TARGET_AVX2
+#else
+#define EDGE_MULTIPLICITY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+//Coordinates are gathered from the edge arrays as floats
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 has to be tightly packed");
+
+EdgeMultiplicityEvaluator::EdgeMultiplicityEvaluator() : EdgeMultiplicityEvaluator(getBestImplementation())
+{
+}
+
+EdgeMultiplicityEvaluator::EdgeMultiplicityEvaluator(Implementation implementation)
+{
+	_implementation = _isSupported(implementation) ? implementation : getBestImplementation();
+
+	if (_implementation != Implementation::SCALAR)
+		_threadPool = BuildThreadPool::getShared();
+}
+
+bool EdgeMultiplicityEvaluator::_isSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case Implementation::SCALAR:
+		return true;
+#ifdef EDGE_MULTIPLICITY_X86
+	case Implementation::AVX2:
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+
+		const bool isAvxEnabled = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+		if (!isAvxEnabled || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+EdgeMultiplicityEvaluator::Implementation EdgeMultiplicityEvaluator::getBestImplementation()
+{
+	static const Implementation best = _isSupported(Implementation::AVX2) ? Implementation::AVX2 : Implementation::SCALAR;
+
+	return best;
+}
+
+EdgeMultiplicityEvaluator::Implementation EdgeMultiplicityEvaluator::getImplementation() const
+{
+	return _implementation;
+}
+
+void EdgeMultiplicityEvaluator::computeMultiplicities(const EdgeStore& edges, const std::vector<int>& edgeIDs, const glm::vec3& lightPos, std::vector<int>& multiplicities) const
+{
+	const int numEdges = int(edgeIDs.size());
+
+	multiplicities.resize(edgeIDs.size());
+
+#ifdef EDGE_MULTIPLICITY_X86
+	if (_implementation == Implementation::AVX2)
+	{
+		if (numEdges <= EDGE_MULTIPLICITY_CHUNK_SIZE)
+		{
+			_computeRangeAvx2(edges, edgeIDs.data(), numEdges, lightPos, multiplicities.data());
+			return;
+		}
+
+		_threadPool->parallelFor(0, numEdges, EDGE_MULTIPLICITY_CHUNK_SIZE, [&](int begin, int end)
+		{
+			_computeRangeAvx2(edges, edgeIDs.data() + begin, end - begin, lightPos, multiplicities.data() + begin);
+		});
+
+		return;
+	}
+#endif
+
+	_computeRangeScalar(edges, edgeIDs.data(), numEdges, lightPos, multiplicities.data());
+}
+
+void EdgeMultiplicityEvaluator::_computeRangeScalar(const EdgeStore& edges, const int* edgeIDs, int numEdges, const glm::vec3& lightPos, int* multiplicities)
+{
+	for (int i = 0; i < numEdges; ++i)
+		multiplicities[i] = GeometryOps::calcEdgeMultiplicity(edges, edgeIDs[i], lightPos);
+}
+
+#ifdef EDGE_MULTIPLICITY_X86
+static EDGE_MULTIPLICITY_TARGET_AVX2 __m256d gatherCoordinates(const glm::vec3* points, __m128i offsets, int component)
+{
+	return _mm256_cvtps_pd(_mm_i32gather_ps(&points->x + component, offsets, 4));
+}
+
+//Bit i is 1 if the sign of the determinant in lane i is certain, positive and negative signs are returned separately
+static EDGE_MULTIPLICITY_TARGET_AVX2 void filterOrient3d(const __m256d (&e1)[3], const __m256d (&e2)[3], const __m256d (&e3)[3], int& positiveMask, int& negativeMask)
+{
+	const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffll));
+
+	//Same expression as RobustPredicates::orient3d
+	const __m256d e1ye2z = _mm256_mul_pd(e1[1], e2[2]), e1ze2y = _mm256_mul_pd(e1[2], e2[1]);
+	const __m256d e1ze2x = _mm256_mul_pd(e1[2], e2[0]), e1xe2z = _mm256_mul_pd(e1[0], e2[2]);
+	const __m256d e1xe2y = _mm256_mul_pd(e1[0], e2[1]), e1ye2x = _mm256_mul_pd(e1[1], e2[0]);
+
+	const __m256d det = _mm256_add_pd(_mm256_add_pd(
+		_mm256_mul_pd(_mm256_sub_pd(e1ye2z, e1ze2y), e3[0]),
+		_mm256_mul_pd(_mm256_sub_pd(e1ze2x, e1xe2z), e3[1])),
+		_mm256_mul_pd(_mm256_sub_pd(e1xe2y, e1ye2x), e3[2]));
+
+	const __m256d permanent = _mm256_add_pd(_mm256_add_pd(
+		_mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(e1ye2z, absMask), _mm256_and_pd(e1ze2y, absMask)), _mm256_and_pd(e3[0], absMask)),
+		_mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(e1ze2x, absMask), _mm256_and_pd(e1xe2z, absMask)), _mm256_and_pd(e3[1], absMask))),
+		_mm256_mul_pd(_mm256_add_pd(_mm256_and_pd(e1xe2y, absMask), _mm256_and_pd(e1ye2x, absMask)), _mm256_and_pd(e3[2], absMask)));
+
+	const __m256d errorBound = _mm256_mul_pd(_mm256_set1_pd(ROBUST_ORIENT3D_ERROR_BOUND), permanent);
+
+	positiveMask = _mm256_movemask_pd(_mm256_cmp_pd(det, errorBound, _CMP_GT_OQ));
+	negativeMask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_sub_pd(_mm256_setzero_pd(), det), errorBound, _CMP_GT_OQ));
+}
+
+EDGE_MULTIPLICITY_TARGET_AVX2 void EdgeMultiplicityEvaluator::_computeRangeAvx2(const EdgeStore& edges, const int* edgeIDs, int numEdges, const glm::vec3& lightPos, int* multiplicities)
+{
+	const glm::vec3* lowerPoints = edges.getLowerPointData();
+	const glm::vec3* higherPoints = edges.getHigherPointData();
+	const int* numOppositeVertices = reinterpret_cast<const int*>(edges.getNumOppositeVerticesData());
+
+	const __m256d light[3] = { _mm256_set1_pd(lightPos.x), _mm256_set1_pd(lightPos.y), _mm256_set1_pd(lightPos.z) };
+
+	int i = 0;
+
+	for (; i + 4 <= numEdges; i += 4)
+	{
+		const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(edgeIDs + i));
+		const __m128i offsets = _mm_mullo_epi32(ids, _mm_set1_epi32(3));
+		const __m128i counts = _mm_i32gather_epi32(numOppositeVertices, ids, 4);
+
+		//Lanes of edges with an opposite vertex in the slot, edges with more of them are left to the scalar path
+		const int usesSlot[EDGE_STORE_NUM_OPPOSITE_SLOTS] = {
+			_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(counts, _mm_set1_epi32(0)))),
+			_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(counts, _mm_set1_epi32(1))))
+		};
+		int uncertainMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(counts, _mm_set1_epi32(EDGE_STORE_NUM_OPPOSITE_SLOTS))));
+
+		__m256d lower[3], e1[3], e3[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			lower[c] = gatherCoordinates(lowerPoints, offsets, c);
+			e1[c] = _mm256_sub_pd(gatherCoordinates(higherPoints, offsets, c), lower[c]);
+			e3[c] = _mm256_sub_pd(light[c], lower[c]);
+		}
+
+		__m128i laneMultiplicities = _mm_setzero_si128();
+
+		for (unsigned int slot = 0; slot < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++slot)
+		{
+			const glm::vec3* oppositeVertices = edges.getOppositeVertexData(slot);
+
+			__m256d e2[3];
+			for (int c = 0; c < 3; ++c)
+				e2[c] = _mm256_sub_pd(gatherCoordinates(oppositeVertices, offsets, c), lower[c]);
+
+			//orient3d(lower, higher, opposite, light), the sign currentMultiplicity computes in any vertex order
+			int positiveMask, negativeMask;
+			filterOrient3d(e1, e2, e3, positiveMask, negativeMask);
+
+			positiveMask &= usesSlot[slot];
+			negativeMask &= usesSlot[slot];
+			uncertainMask |= usesSlot[slot] & ~(positiveMask | negativeMask);
+
+			//Lane bits turned into +1 and -1
+			const __m128i laneBits = _mm_set_epi32(8, 4, 2, 1);
+			const __m128i isPositive = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(positiveMask), laneBits), laneBits);
+			const __m128i isNegative = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(negativeMask), laneBits), laneBits);
+			laneMultiplicities = _mm_add_epi32(laneMultiplicities, _mm_sub_epi32(isNegative, isPositive));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(multiplicities + i), laneMultiplicities);
+
+		for (int lane = 0; uncertainMask; ++lane, uncertainMask >>= 1)
+		{
+			if (uncertainMask & 1)
+				multiplicities[i + lane] = GeometryOps::calcEdgeMultiplicity(edges, edgeIDs[i + lane], lightPos);
+		}
+	}
+
+	_computeRangeScalar(edges, edgeIDs + i, numEdges - i, lightPos, multiplicities + i);
+}
+#endif
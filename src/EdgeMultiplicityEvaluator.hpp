@@ -0,0 +1,51 @@
+#pragma once
+
+#include "EdgeStore.hpp"
+#include "BuildThreadPool.hpp"
+
+#include <vector>
+#include <memory>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define EDGE_MULTIPLICITY_X86
+#endif
+
+//Edges per task when the batch is split across the workers of the shared build pool
+#define EDGE_MULTIPLICITY_CHUNK_SIZE 2048
+
+//Multiplicities of many edges for one light, the same values as GeometryOps::calcEdgeMultiplicity
+//Orientation is exact, so it does not depend on the order of the triangle's vertices,
+//the vectorized path evaluates the double filter of orient3d for 4 edges at once without ordering them
+//and passes the edges the filter cannot decide to the scalar path
+//Without AVX2 the batch is the plain per-edge loop on the calling thread, chunking and threads did not pay off there
+class EdgeMultiplicityEvaluator
+{
+public:
+	enum class Implementation : int
+	{
+		SCALAR = 0,
+		AVX2 = 1
+	};
+
+	//Uses the best implementation the CPU supports
+	EdgeMultiplicityEvaluator();
+	//Unsupported implementations are replaced by the best supported one
+	explicit EdgeMultiplicityEvaluator(Implementation implementation);
+
+	static Implementation getBestImplementation();
+	Implementation getImplementation() const;
+
+	//multiplicities[i] belongs to edgeIDs[i]
+	void computeMultiplicities(const EdgeStore& edges, const std::vector<int>& edgeIDs, const glm::vec3& lightPos, std::vector<int>& multiplicities) const;
+
+private:
+	static void _computeRangeScalar(const EdgeStore& edges, const int* edgeIDs, int numEdges, const glm::vec3& lightPos, int* multiplicities);
+#ifdef EDGE_MULTIPLICITY_X86
+	static void _computeRangeAvx2(const EdgeStore& edges, const int* edgeIDs, int numEdges, const glm::vec3& lightPos, int* multiplicities);
+#endif
+
+	static bool _isSupported(Implementation implementation);
+
+	Implementation	_implementation;
+	std::shared_ptr<BuildThreadPool> _threadPool;
+};
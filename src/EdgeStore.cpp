@@ -0,0 +1,125 @@
+#include "EdgeStore.hpp"
+#include "GeometryOperations.hpp"
+
+void EdgeStore::clear()
+{
+	_lowerPoints.clear();
+	_higherPoints.clear();
+	_numOppositeVertices.clear();
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		_oppositeVertices[i].clear();
+		_planes[i].clear();
+	}
+
+	_extraOppositeVertices.clear();
+}
+
+void EdgeStore::reserve(size_t numEdges)
+{
+	_lowerPoints.reserve(numEdges);
+	_higherPoints.reserve(numEdges);
+	_numOppositeVertices.reserve(numEdges);
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		_oppositeVertices[i].reserve(numEdges);
+		_planes[i].reserve(numEdges);
+	}
+}
+
+unsigned int EdgeStore::addEdge(const Edge& edge, const glm::vec3* oppositeVertices, unsigned int numOppositeVertices)
+{
+	const unsigned int edgeID = unsigned(_lowerPoints.size());
+
+	_lowerPoints.push_back(edge.lowerPoint);
+	_higherPoints.push_back(edge.higherPoint);
+	_numOppositeVertices.push_back(0);
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		_oppositeVertices[i].push_back(glm::vec3(0));
+		_planes[i].push_back(FilteredPlane());
+	}
+
+	_setOppositeVertices(edgeID, oppositeVertices, numOppositeVertices);
+
+	return edgeID;
+}
+
+unsigned int EdgeStore::addEdge(const EdgeStore& source, unsigned int sourceID)
+{
+	const unsigned int edgeID = unsigned(_lowerPoints.size());
+
+	_lowerPoints.push_back(glm::vec3(0));
+	_higherPoints.push_back(glm::vec3(0));
+	_numOppositeVertices.push_back(0);
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		_oppositeVertices[i].push_back(glm::vec3(0));
+		_planes[i].push_back(FilteredPlane());
+	}
+
+	setEdge(edgeID, source, sourceID);
+
+	return edgeID;
+}
+
+void EdgeStore::setEdge(unsigned int edgeID, const EdgeStore& source, unsigned int sourceID)
+{
+	_lowerPoints[edgeID] = source._lowerPoints[sourceID];
+	_higherPoints[edgeID] = source._higherPoints[sourceID];
+	_numOppositeVertices[edgeID] = source._numOppositeVertices[sourceID];
+
+	//Planes are copied rather than rebuilt, so they stay bit-identical
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		_oppositeVertices[i][edgeID] = source._oppositeVertices[i][sourceID];
+		_planes[i][edgeID] = source._planes[i][sourceID];
+	}
+
+	const auto extra = source._extraOppositeVertices.find(sourceID);
+
+	if (extra != source._extraOppositeVertices.end())
+		_extraOppositeVertices[edgeID] = extra->second;
+	else
+		_extraOppositeVertices.erase(edgeID);
+}
+
+void EdgeStore::clearOppositeVertices(unsigned int edgeID)
+{
+	_setOppositeVertices(edgeID, nullptr, 0);
+}
+
+void EdgeStore::_setOppositeVertices(unsigned int edgeID, const glm::vec3* oppositeVertices, unsigned int numOppositeVertices)
+{
+	_numOppositeVertices[edgeID] = numOppositeVertices;
+
+	const Edge edge(glm::vec4(_lowerPoints[edgeID], 1), glm::vec4(_higherPoints[edgeID], 1));
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+	{
+		if (i < numOppositeVertices)
+		{
+			_oppositeVertices[i][edgeID] = oppositeVertices[i];
+			GeometryOps::buildEdgeTrianglePlane(edge, oppositeVertices[i], _planes[i][edgeID]);
+		}
+		else
+		{
+			_oppositeVertices[i][edgeID] = glm::vec3(0);
+			_planes[i][edgeID] = FilteredPlane();
+		}
+	}
+
+	if (numOppositeVertices > EDGE_STORE_NUM_OPPOSITE_SLOTS)
+		_extraOppositeVertices[edgeID].assign(oppositeVertices + EDGE_STORE_NUM_OPPOSITE_SLOTS, oppositeVertices + numOppositeVertices);
+	else
+		_extraOppositeVertices.erase(edgeID);
+}
+
+uint64_t EdgeStore::getBytesPerEdge()
+{
+	return 2 * sizeof(glm::vec3) + sizeof(uint32_t) + EDGE_STORE_NUM_OPPOSITE_SLOTS * (sizeof(glm::vec3) + sizeof(FilteredPlane));
+}
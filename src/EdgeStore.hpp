@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Edge.hpp"
+#include "RobustPredicates.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#define EDGE_STORE_NUM_OPPOSITE_SLOTS 2
+
+//Edges with the opposite vertices of their neighbouring triangles, one array per attribute
+//Edges of a closed mesh have two triangles, those fit into the fixed slots together with their planes,
+//opposite vertices of edges shared by more triangles continue in a side table
+class EdgeStore
+{
+public:
+	size_t size() const { return _lowerPoints.size(); }
+	bool empty() const { return _lowerPoints.empty(); }
+
+	void clear();
+	void reserve(size_t numEdges);
+
+	//Returns the ID of the new edge
+	unsigned int addEdge(const Edge& edge, const glm::vec3* oppositeVertices, unsigned int numOppositeVertices);
+	unsigned int addEdge(const EdgeStore& source, unsigned int sourceID);
+
+	void setEdge(unsigned int edgeID, const EdgeStore& source, unsigned int sourceID);
+	//The edge keeps its ID, without neighbouring triangles it is never silhouette
+	void clearOppositeVertices(unsigned int edgeID);
+
+	const glm::vec3& getLowerPoint(unsigned int edgeID) const { return _lowerPoints[edgeID]; }
+	const glm::vec3& getHigherPoint(unsigned int edgeID) const { return _higherPoints[edgeID]; }
+
+	unsigned int getNumOppositeVertices(unsigned int edgeID) const { return _numOppositeVertices[edgeID]; }
+	const glm::vec3& getOppositeVertex(unsigned int edgeID, unsigned int index) const
+	{
+		return index < EDGE_STORE_NUM_OPPOSITE_SLOTS ? _oppositeVertices[index][edgeID] : _extraOppositeVertices.at(edgeID)[index - EDGE_STORE_NUM_OPPOSITE_SLOTS];
+	}
+
+	//Arrays indexed by the edge ID, for kernels that gather the coordinates of several edges
+	const glm::vec3* getLowerPointData() const { return _lowerPoints.data(); }
+	const glm::vec3* getHigherPointData() const { return _higherPoints.data(); }
+	const uint32_t* getNumOppositeVerticesData() const { return _numOppositeVertices.data(); }
+	//Edges that do not use the slot have a zero vector there
+	const glm::vec3* getOppositeVertexData(unsigned int slot) const { return _oppositeVertices[slot].data(); }
+
+	//Plane of the triangle with the opposite vertex in the slot, only valid for the slots the edge uses
+	const FilteredPlane& getPlane(unsigned int edgeID, unsigned int slot) const { return _planes[slot][edgeID]; }
+
+	//Memory of one edge in the arrays, opposite vertices in the side table are not included
+	static uint64_t getBytesPerEdge();
+
+private:
+	void _setOppositeVertices(unsigned int edgeID, const glm::vec3* oppositeVertices, unsigned int numOppositeVertices);
+
+	std::vector<glm::vec3>		_lowerPoints;
+	std::vector<glm::vec3>		_higherPoints;
+
+	std::vector<uint32_t>		_numOppositeVertices;
+	std::vector<glm::vec3>		_oppositeVertices[EDGE_STORE_NUM_OPPOSITE_SLOTS];
+	std::vector<FilteredPlane>	_planes[EDGE_STORE_NUM_OPPOSITE_SLOTS];
+
+	std::unordered_map<unsigned int, std::vector<glm::vec3> > _extraOppositeVertices;
+};
@@ -10,7 +10,7 @@ EdgeVisualizer::~EdgeVisualizer()
 	clear();
 }
 
-void EdgeVisualizer::loadEdges(const EDGE_CONTAINER_TYPE& edges)
+void EdgeVisualizer::loadEdges(const EdgeStore& edges)
 {
 	if (_numEdges)
 		clear();
@@ -21,13 +21,10 @@ void EdgeVisualizer::loadEdges(const EDGE_CONTAINER_TYPE& edges)
 	std::vector<glm::vec4> e;
 	e.resize(_numEdges * 2);
 
-	unsigned int i = 0;
-	for (const auto& edge : edges)
+	for (unsigned int i = 0; i < _numEdges; ++i)
 	{
-		e[i + 0] = glm::vec4(edge.first.lowerPoint, 1);
-		e[i + 1] = glm::vec4(edge.first.higherPoint, 1);
-
-		i += 2;
+		e[2 * i + 0] = glm::vec4(edges.getLowerPoint(i), 1);
+		e[2 * i + 1] = glm::vec4(edges.getHigherPoint(i), 1);
 	}
 
 	glGenVertexArrays(1, &_VAO);
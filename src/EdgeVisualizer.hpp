@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Edge.hpp"
+#include "EdgeStore.hpp"
 
 #include <GL/glew.h>
 
@@ -13,7 +13,7 @@ public:
 	EdgeVisualizer();
 	~EdgeVisualizer();
 	
-	void loadEdges(const EDGE_CONTAINER_TYPE& edges);
+	void loadEdges(const EdgeStore& edges);
 	
 	void drawEdges() const;
 
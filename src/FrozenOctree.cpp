@@ -0,0 +1,755 @@
+#include "FrozenOctree.hpp"
+#include "GeometryOperations.hpp"
+
+#include "BitOperations.h"
+
+#include <queue>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+#define FROZEN_OCTREE_DECODE_CHUNK_SIZE 256
+
+static void writeVarint(uint32_t value, std::vector<unsigned char>& stream)
+{
+	while (value >= 0x80)
+	{
+		stream.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+
+	stream.push_back((unsigned char)value);
+}
+
+static uint32_t readVarint(const unsigned char*& stream)
+{
+	uint32_t value = 0;
+	unsigned int shift = 0;
+
+	while (*stream & 0x80)
+	{
+		value |= uint32_t(*stream++ & 0x7F) << shift;
+		shift += 7;
+	}
+
+	return value | (uint32_t(*stream++) << shift);
+}
+
+//Expects sorted input, the first value is stored as is
+static void writeDeltaVarints(const std::vector<unsigned int>& sortedValues, std::vector<unsigned char>& stream)
+{
+	unsigned int previous = 0;
+	for (const auto value : sortedValues)
+	{
+		writeVarint(value - previous, stream);
+		previous = value;
+	}
+}
+
+//Walks a built octree breadth-first
+class OctreeNodeQueue : public FrozenOctreeNodeSource
+{
+public:
+	OctreeNodeQueue(const Octree& octree) : _octree(octree)
+	{
+		_nodeQueue.push(0);
+	}
+
+	AABB getRootVolume() const override
+	{
+		return _octree.getNodeVolume(0);
+	}
+
+	unsigned int getDeepestLevel() const override
+	{
+		return _octree.getDeepestLevel();
+	}
+
+	uint64_t getNumNodes() const override
+	{
+		return _octree.getNumMaterializedNodes();
+	}
+
+	bool getNextNode(SourceNode& sourceNode) override
+	{
+		if (_nodeQueue.empty())
+			return false;
+
+		sourceNode.nodeID = _nodeQueue.front();
+		_nodeQueue.pop();
+
+		sourceNode.level = _octree.getNodeRecursionLevel(sourceNode.nodeID);
+		sourceNode.node = _octree.getNode(sourceNode.nodeID);
+		sourceNode.splitPoint = _octree.getNodeSplitPoint(sourceNode.nodeID);
+		sourceNode.childMask = 0;
+
+		assert(sourceNode.node != nullptr);
+
+		if (sourceNode.level < _octree.getDeepestLevel())
+		{
+			const int startingChild = _octree.getChildrenStartingId(sourceNode.nodeID);
+
+			for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			{
+				if (_octree.nodeExists(startingChild + i))
+				{
+					sourceNode.childMask |= 1 << i;
+					_nodeQueue.push(startingChild + i);
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	const Octree&			 _octree;
+	std::queue<unsigned int> _nodeQueue;
+};
+
+FrozenOctree::FrozenOctree()
+{
+	clear();
+}
+
+void FrozenOctree::clear()
+{
+	_volume = AABB();
+
+	_edgesMayCastPool.clear();
+	_edgesAlwaysCastPool.clear();
+	_edgesMayCastOffsets.clear();
+	_edgesAlwaysCastOffsets.clear();
+	_firstChild.clear();
+	_childMask.clear();
+	_nodeEdgeLists.clear();
+	_levelStarts.clear();
+	_splitPoints.clear();
+	_compressedEdges.clear();
+	_compressedEdgesOffsets.clear();
+}
+
+bool FrozenOctree::isValid() const
+{
+	return !_firstChild.empty();
+}
+
+bool FrozenOctree::isCompressed() const
+{
+	return !_compressedEdgesOffsets.empty();
+}
+
+void FrozenOctree::freeze(const Octree& octree, bool compressEdgeLists)
+{
+	OctreeNodeQueue nodeQueue(octree);
+	freeze(nodeQueue, compressEdgeLists);
+}
+
+void FrozenOctree::freeze(FrozenOctreeNodeSource& nodeSource, bool compressEdgeLists)
+{
+	clear();
+
+	_volume = nodeSource.getRootVolume();
+
+	const uint64_t numNodes = nodeSource.getNumNodes();
+
+	std::vector<unsigned int> edgesMayCastPool, edgesMayCastOffsets, edgesAlwaysCastOffsets, firstChild, nodeEdgeLists, levelStarts, compressedEdgesOffsets;
+	std::vector<int> edgesAlwaysCastPool;
+	std::vector<unsigned char> childMask, compressedEdges, nodeCompressedEdges;
+	std::vector<glm::vec3> splitPoints;
+	bool hasCustomSplitPoints = false;
+
+	firstChild.reserve(numNodes);
+	nodeEdgeLists.reserve(numNodes);
+	childMask.reserve(numNodes);
+	splitPoints.reserve(numNodes);
+
+	if (compressEdgeLists)
+		compressedEdgesOffsets.push_back(0);
+	else
+	{
+		edgesMayCastOffsets.push_back(0);
+		edgesAlwaysCastOffsets.push_back(0);
+	}
+
+	//Identical edge lists are stored once, candidates are found by the hash of their content
+	std::unordered_multimap<uint64_t, unsigned int> listsByHash;
+	unsigned int numLists = 0;
+
+	//Breadth-first, so that each level and each group of syblings is contiguous
+	FrozenOctreeNodeSource::SourceNode sourceNode;
+
+	unsigned int numEnqueued = 1;
+	int currentLevel = -1;
+
+	while (nodeSource.getNextNode(sourceNode))
+	{
+		const int level = int(sourceNode.level);
+		if (level != currentLevel)
+		{
+			levelStarts.push_back(firstChild.size());
+			currentLevel = level;
+		}
+
+		const auto node = sourceNode.node;
+
+		CacheHasher listHasher;
+		if (compressEdgeLists)
+		{
+			nodeCompressedEdges.clear();
+			_compressNodeEdges(*node, nodeCompressedEdges);
+			listHasher.add(nodeCompressedEdges.data(), nodeCompressedEdges.size());
+		}
+		else
+		{
+			listHasher.addValue(uint64_t(node->edgesMayCast.size()));
+			listHasher.add(node->edgesMayCast.data(), node->edgesMayCast.size() * sizeof(unsigned int));
+			listHasher.add(node->edgesAlwaysCast.data(), node->edgesAlwaysCast.size() * sizeof(int));
+		}
+
+		const uint64_t listHash = listHasher.getHash();
+		unsigned int listID = numLists;
+
+		const auto candidates = listsByHash.equal_range(listHash);
+		for (auto it = candidates.first; it != candidates.second && listID == numLists; ++it)
+		{
+			const unsigned int candidate = it->second;
+
+			if (compressEdgeLists)
+			{
+				if ((compressedEdgesOffsets[candidate + 1] - compressedEdgesOffsets[candidate]) == nodeCompressedEdges.size() &&
+					std::equal(nodeCompressedEdges.begin(), nodeCompressedEdges.end(), compressedEdges.begin() + compressedEdgesOffsets[candidate]))
+					listID = candidate;
+			}
+			else
+			{
+				if ((edgesMayCastOffsets[candidate + 1] - edgesMayCastOffsets[candidate]) == node->edgesMayCast.size() &&
+					(edgesAlwaysCastOffsets[candidate + 1] - edgesAlwaysCastOffsets[candidate]) == node->edgesAlwaysCast.size() &&
+					std::equal(node->edgesMayCast.begin(), node->edgesMayCast.end(), edgesMayCastPool.begin() + edgesMayCastOffsets[candidate]) &&
+					std::equal(node->edgesAlwaysCast.begin(), node->edgesAlwaysCast.end(), edgesAlwaysCastPool.begin() + edgesAlwaysCastOffsets[candidate]))
+					listID = candidate;
+			}
+		}
+
+		if (listID == numLists)
+		{
+			if (compressEdgeLists)
+			{
+				compressedEdges.insert(compressedEdges.end(), nodeCompressedEdges.begin(), nodeCompressedEdges.end());
+				compressedEdgesOffsets.push_back(compressedEdges.size());
+			}
+			else
+			{
+				edgesMayCastPool.insert(edgesMayCastPool.end(), node->edgesMayCast.begin(), node->edgesMayCast.end());
+				edgesAlwaysCastPool.insert(edgesAlwaysCastPool.end(), node->edgesAlwaysCast.begin(), node->edgesAlwaysCast.end());
+				edgesMayCastOffsets.push_back(edgesMayCastPool.size());
+				edgesAlwaysCastOffsets.push_back(edgesAlwaysCastPool.size());
+			}
+
+			listsByHash.insert(std::make_pair(listHash, listID));
+			++numLists;
+		}
+
+		nodeEdgeLists.push_back(listID);
+
+		const glm::vec3 splitPoint = sourceNode.splitPoint;
+		hasCustomSplitPoints |= splitPoint != Octree::getChildVolume(node->volume, 0).getMaxPoint();
+		splitPoints.push_back(splitPoint);
+
+		const unsigned char mask = sourceNode.childMask;
+		const unsigned int firstChildIndex = numEnqueued;
+		numEnqueued += CountSetBits(mask);
+
+		//Leaves point nowhere, so that equal leaves compare equal when merging subtrees
+		firstChild.push_back(mask ? firstChildIndex : 0);
+		childMask.push_back(mask);
+	}
+
+	_mergeIdenticalSubtrees(firstChild, childMask, nodeEdgeLists, splitPoints, levelStarts, hasCustomSplitPoints);
+
+	_edgesMayCastPool.assign(std::move(edgesMayCastPool));
+	_edgesAlwaysCastPool.assign(std::move(edgesAlwaysCastPool));
+	_edgesMayCastOffsets.assign(std::move(edgesMayCastOffsets));
+	_edgesAlwaysCastOffsets.assign(std::move(edgesAlwaysCastOffsets));
+	_firstChild.assign(std::move(firstChild));
+	_childMask.assign(std::move(childMask));
+	_nodeEdgeLists.assign(std::move(nodeEdgeLists));
+	_levelStarts.assign(std::move(levelStarts));
+	if (hasCustomSplitPoints)
+		_splitPoints.assign(std::move(splitPoints));
+	_compressedEdges.assign(std::move(compressedEdges));
+	_compressedEdgesOffsets.assign(std::move(compressedEdgesOffsets));
+}
+
+void FrozenOctree::_mergeIdenticalSubtrees(std::vector<unsigned int>& firstChild, std::vector<unsigned char>& childMask, std::vector<unsigned int>& nodeEdgeLists, std::vector<glm::vec3>& splitPoints, std::vector<unsigned int>& levelStarts, bool compareSplitPoints)
+{
+	const size_t numNodes = firstChild.size();
+
+	std::vector<bool> isRemoved(numNodes, false);
+
+	//Bottom-up, children of the compared blocks are merged already, so equal subtrees have equal child indices
+	//Parents with different child masks may share a block too, each reads it through its own mask
+	std::map<std::vector<unsigned int>, unsigned int> uniqueBlocks;
+	std::vector<unsigned int> blockKey;
+
+	for (int level = int(levelStarts.size()) - 2; level >= 0; --level)
+	{
+		uniqueBlocks.clear();
+
+		for (unsigned int parent = levelStarts[level]; parent < levelStarts[level + 1]; ++parent)
+		{
+			if (!childMask[parent])
+				continue;
+
+			const unsigned int blockStart = firstChild[parent];
+			const unsigned int blockEnd = blockStart + CountSetBits(childMask[parent]);
+
+			blockKey.clear();
+			for (unsigned int child = blockStart; child < blockEnd; ++child)
+			{
+				blockKey.push_back(nodeEdgeLists[child]);
+				blockKey.push_back(childMask[child]);
+				blockKey.push_back(firstChild[child]);
+
+				if (compareSplitPoints)
+				{
+					unsigned int splitPointBits[3];
+					memcpy(splitPointBits, &splitPoints[child], sizeof(splitPointBits));
+					blockKey.insert(blockKey.end(), splitPointBits, splitPointBits + 3);
+				}
+			}
+
+			const auto inserted = uniqueBlocks.insert(std::make_pair(blockKey, blockStart));
+
+			if (inserted.second)
+				continue;
+
+			for (unsigned int child = blockStart; child < blockEnd; ++child)
+				isRemoved[child] = true;
+
+			firstChild[parent] = inserted.first->second;
+		}
+	}
+
+	//Removed blocks are only referenced by their former parents, the rest is compacted in place
+	std::vector<unsigned int> newIndex(numNodes);
+	unsigned int numKept = 0;
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		newIndex[i] = numKept;
+		numKept += !isRemoved[i];
+	}
+
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		if (isRemoved[i])
+			continue;
+
+		const unsigned int target = newIndex[i];
+
+		firstChild[target] = childMask[i] ? newIndex[firstChild[i]] : 0;
+		childMask[target] = childMask[i];
+		nodeEdgeLists[target] = nodeEdgeLists[i];
+		splitPoints[target] = splitPoints[i];
+	}
+
+	firstChild.resize(numKept);
+	childMask.resize(numKept);
+	nodeEdgeLists.resize(numKept);
+	splitPoints.resize(numKept);
+
+	for (auto& levelStart : levelStarts)
+		levelStart = newIndex[levelStart];
+}
+
+void FrozenOctree::_compressNodeEdges(const Node& node, std::vector<unsigned char>& compressedEdges)
+{
+	std::vector<unsigned int> mayCast(node.edgesMayCast.begin(), node.edgesMayCast.end());
+	std::vector<unsigned int> positive, negative;
+
+	for (const auto edge : node.edgesAlwaysCast)
+	{
+		if (decodeSilhouetteEdgeSign(edge) > 0)
+			positive.push_back(decodeSilhouetteEdgeID(edge));
+		else
+			negative.push_back(decodeSilhouetteEdgeID(edge));
+	}
+
+	std::sort(mayCast.begin(), mayCast.end());
+	std::sort(positive.begin(), positive.end());
+	std::sort(negative.begin(), negative.end());
+
+	writeVarint(mayCast.size(), compressedEdges);
+	writeVarint(positive.size(), compressedEdges);
+	writeVarint(negative.size(), compressedEdges);
+
+	writeDeltaVarints(mayCast, compressedEdges);
+	writeDeltaVarints(positive, compressedEdges);
+	writeDeltaVarints(negative, compressedEdges);
+}
+
+void FrozenOctree::_getCompressedEdgeListCounts(unsigned int list, unsigned int& numMayCast, unsigned int& numAlwaysCast) const
+{
+	const unsigned char* stream = _compressedEdges.data() + _compressedEdgesOffsets[list];
+
+	numMayCast = readVarint(stream);
+	numAlwaysCast = readVarint(stream);
+	numAlwaysCast += readVarint(stream);
+}
+
+void FrozenOctree::_visitCompressedEdgeList(unsigned int list, SilhouetteEdgeVisitor& visitor) const
+{
+	const unsigned char* stream = _compressedEdges.data() + _compressedEdgesOffsets[list];
+
+	const uint32_t numMayCast = readVarint(stream);
+	const uint32_t numPositive = readVarint(stream);
+	const uint32_t numNegative = readVarint(stream);
+
+	//Decoded in fixed-size chunks, so that visiting never allocates
+	unsigned int potential[FROZEN_OCTREE_DECODE_CHUNK_SIZE];
+	int silhouette[FROZEN_OCTREE_DECODE_CHUNK_SIZE];
+
+	uint32_t edge = 0;
+	unsigned int numDecoded = 0;
+	for (uint32_t i = 0; i < numMayCast; ++i)
+	{
+		edge += readVarint(stream);
+		potential[numDecoded++] = edge;
+
+		if (numDecoded == FROZEN_OCTREE_DECODE_CHUNK_SIZE || (i + 1) == numMayCast)
+		{
+			visitor.visitPotentialEdges(potential, potential + numDecoded);
+			numDecoded = 0;
+		}
+	}
+
+	const uint32_t numSilhouette = numPositive + numNegative;
+
+	for (uint32_t i = 0; i < numSilhouette; ++i)
+	{
+		//Negative list restarts the delta coding
+		if (i == 0 || i == numPositive)
+			edge = 0;
+
+		edge += readVarint(stream);
+		silhouette[numDecoded++] = encodeSilhouetteEdge(edge, i < numPositive ? 1 : -1);
+
+		if (numDecoded == FROZEN_OCTREE_DECODE_CHUNK_SIZE || (i + 1) == numSilhouette)
+		{
+			visitor.visitSilhouetteEdges(silhouette, silhouette + numDecoded);
+			numDecoded = 0;
+		}
+	}
+
+	assert(stream <= _compressedEdges.data() + _compressedEdgesOffsets[list + 1]);
+}
+
+void FrozenOctree::visitNodeEdges(unsigned int node, SilhouetteEdgeVisitor& visitor) const
+{
+	const unsigned int list = _nodeEdgeLists[node];
+
+	if (isCompressed())
+	{
+		_visitCompressedEdgeList(list, visitor);
+		return;
+	}
+
+	const unsigned int numMayCast = _edgesMayCastOffsets[list + 1] - _edgesMayCastOffsets[list];
+	const unsigned int numAlwaysCast = _edgesAlwaysCastOffsets[list + 1] - _edgesAlwaysCastOffsets[list];
+
+	if (numAlwaysCast)
+		visitor.visitSilhouetteEdges(_edgesAlwaysCastPool.data() + _edgesAlwaysCastOffsets[list], _edgesAlwaysCastPool.data() + _edgesAlwaysCastOffsets[list + 1]);
+
+	if (numMayCast)
+		visitor.visitPotentialEdges(_edgesMayCastPool.data() + _edgesMayCastOffsets[list], _edgesMayCastPool.data() + _edgesMayCastOffsets[list + 1]);
+}
+
+void FrozenOctree::getNodeEdges(unsigned int node, std::vector<int>& potential, std::vector<int>& silhouette) const
+{
+	SilhouetteEdgeCollector collector(potential, silhouette);
+	visitNodeEdges(node, collector);
+}
+
+void FrozenOctree::save(StructureCacheWriter& writer) const
+{
+	writer.writeArray(&_volume, 1);
+	writer.writeArray(_edgesMayCastPool.data(), _edgesMayCastPool.size());
+	writer.writeArray(_edgesAlwaysCastPool.data(), _edgesAlwaysCastPool.size());
+	writer.writeArray(_edgesMayCastOffsets.data(), _edgesMayCastOffsets.size());
+	writer.writeArray(_edgesAlwaysCastOffsets.data(), _edgesAlwaysCastOffsets.size());
+	writer.writeArray(_firstChild.data(), _firstChild.size());
+	writer.writeArray(_childMask.data(), _childMask.size());
+	writer.writeArray(_nodeEdgeLists.data(), _nodeEdgeLists.size());
+	writer.writeArray(_levelStarts.data(), _levelStarts.size());
+	writer.writeArray(_splitPoints.data(), _splitPoints.size());
+	writer.writeArray(_compressedEdges.data(), _compressedEdges.size());
+	writer.writeArray(_compressedEdgesOffsets.data(), _compressedEdgesOffsets.size());
+}
+
+bool FrozenOctree::load(StructureCacheReader& reader)
+{
+	clear();
+
+	const AABB* volume = nullptr;
+	const unsigned int *edgesMayCastPool = nullptr, *edgesMayCastOffsets = nullptr, *edgesAlwaysCastOffsets = nullptr, *firstChild = nullptr, *levelStarts = nullptr;
+	const int* edgesAlwaysCastPool = nullptr;
+	const unsigned int *compressedEdgesOffsets = nullptr, *nodeEdgeLists = nullptr;
+	const unsigned char *childMask = nullptr, *compressedEdges = nullptr;
+	const glm::vec3* splitPoints = nullptr;
+
+	size_t numVolumes, numMayCast, numAlwaysCast, numMayCastOffsets, numAlwaysCastOffsets, numNodes, numMasks, numNodeEdgeLists, numLevels, numSplitPoints, numCompressedBytes, numCompressedOffsets;
+
+	bool success = reader.readArray(volume, numVolumes);
+	success = success && reader.readArray(edgesMayCastPool, numMayCast);
+	success = success && reader.readArray(edgesAlwaysCastPool, numAlwaysCast);
+	success = success && reader.readArray(edgesMayCastOffsets, numMayCastOffsets);
+	success = success && reader.readArray(edgesAlwaysCastOffsets, numAlwaysCastOffsets);
+	success = success && reader.readArray(firstChild, numNodes);
+	success = success && reader.readArray(childMask, numMasks);
+	success = success && reader.readArray(nodeEdgeLists, numNodeEdgeLists);
+	success = success && reader.readArray(levelStarts, numLevels);
+	success = success && reader.readArray(splitPoints, numSplitPoints);
+	success = success && reader.readArray(compressedEdges, numCompressedBytes);
+	success = success && reader.readArray(compressedEdgesOffsets, numCompressedOffsets);
+
+	if (!success || numVolumes != 1 || numNodes == 0 || numMasks != numNodes || numNodeEdgeLists != numNodes || (numSplitPoints && numSplitPoints != numNodes))
+		return false;
+
+	//Either the plain pools or the compressed stream are present
+	size_t numLists = 0;
+	if (numCompressedOffsets)
+	{
+		numLists = numCompressedOffsets - 1;
+
+		if (compressedEdgesOffsets[numLists] != numCompressedBytes || numMayCastOffsets || numAlwaysCastOffsets)
+			return false;
+	}
+	else
+	{
+		if (numMayCastOffsets == 0 || numAlwaysCastOffsets != numMayCastOffsets)
+			return false;
+
+		numLists = numMayCastOffsets - 1;
+
+		if (edgesMayCastOffsets[numLists] != numMayCast || edgesAlwaysCastOffsets[numLists] != numAlwaysCast)
+			return false;
+	}
+
+	//Offsets delimit the lists, a decreasing one would make a list reach outside its pool
+	const unsigned int* listOffsets = numCompressedOffsets ? compressedEdgesOffsets : edgesMayCastOffsets;
+	for (size_t i = 0; i < numLists; ++i)
+	{
+		if (listOffsets[i] > listOffsets[i + 1] || (!numCompressedOffsets && edgesAlwaysCastOffsets[i] > edgesAlwaysCastOffsets[i + 1]))
+			return false;
+	}
+
+	//Levels are contiguous and start at the root
+	if (numLevels == 0 || levelStarts[0] != 0)
+		return false;
+
+	for (size_t i = 0; i < numLevels; ++i)
+	{
+		if (levelStarts[i] > numNodes || (i && levelStarts[i] < levelStarts[i - 1]))
+			return false;
+	}
+
+	//Children lie after their parent, so traversals terminate, and inside the node arrays
+	for (size_t i = 0; i < numNodes; ++i)
+	{
+		if (nodeEdgeLists[i] >= numLists)
+			return false;
+
+		if (childMask[i] && (firstChild[i] <= i || uint64_t(firstChild[i]) + CountSetBits(childMask[i]) > numNodes))
+			return false;
+	}
+
+	_volume = *volume;
+	_edgesMayCastPool.reference(edgesMayCastPool, numMayCast);
+	_edgesAlwaysCastPool.reference(edgesAlwaysCastPool, numAlwaysCast);
+	_edgesMayCastOffsets.reference(edgesMayCastOffsets, numMayCastOffsets);
+	_edgesAlwaysCastOffsets.reference(edgesAlwaysCastOffsets, numAlwaysCastOffsets);
+	_firstChild.reference(firstChild, numNodes);
+	_childMask.reference(childMask, numMasks);
+	_nodeEdgeLists.reference(nodeEdgeLists, numNodeEdgeLists);
+	_levelStarts.reference(levelStarts, numLevels);
+	_splitPoints.reference(splitPoints, numSplitPoints);
+	_compressedEdges.reference(compressedEdges, numCompressedBytes);
+	_compressedEdgesOffsets.reference(compressedEdgesOffsets, numCompressedOffsets);
+
+	return true;
+}
+
+int FrozenOctree::_getChildContainingPoint(unsigned int node, const AABB& nodeVolume, const glm::vec3& point, AABB& childVolume, unsigned int& childIndex) const
+{
+	const glm::vec3 centerPoint = _splitPoints.empty() ? nodeVolume.getCenterPoint() : _splitPoints[node];
+
+	childIndex = (point.x >= centerPoint.x) + 2 * (point.y >= centerPoint.y) + 4 * (point.z >= centerPoint.z);
+	const unsigned int mask = _childMask[node];
+
+	if (!(mask & (1 << childIndex)))
+		return -1;
+
+	childVolume = _splitPoints.empty() ? Octree::getChildVolume(nodeVolume, childIndex) : Octree::getChildVolume(nodeVolume, childIndex, _splitPoints[node]);
+
+	//Existing children are stored in order, skip those preceding this one
+	return _firstChild[node] + CountSetBits(mask & ((1 << childIndex) - 1));
+}
+
+int FrozenOctree::getLowestNodeIndexFromPoint(const glm::vec3& point) const
+{
+	if (!isValid() || !GeometryOps::testAabbPointIsInsideOrOn(_volume, point))
+		return -1;
+
+	int currentNode = 0;
+	AABB currentVolume = _volume;
+
+	while (true)
+	{
+		AABB childVolume;
+		unsigned int childIndex;
+		const int child = _getChildContainingPoint(currentNode, currentVolume, point, childVolume, childIndex);
+
+		if (child < 0)
+			break;
+
+		currentNode = child;
+		currentVolume = childVolume;
+	}
+
+	return currentNode;
+}
+
+int FrozenOctree::getLowestNodeCellIDFromPoint(const glm::vec3& point) const
+{
+	if (!isValid() || !GeometryOps::testAabbPointIsInsideOrOn(_volume, point))
+		return -1;
+
+	int currentNode = 0;
+	int currentCellID = 0;
+	AABB currentVolume = _volume;
+
+	while (true)
+	{
+		AABB childVolume;
+		unsigned int childIndex;
+		const int child = _getChildContainingPoint(currentNode, currentVolume, point, childVolume, childIndex);
+
+		if (child < 0)
+			break;
+
+		currentNode = child;
+		currentCellID = NodeAddressing::getChildrenStartingID(currentCellID) + childIndex;
+		currentVolume = childVolume;
+	}
+
+	return currentCellID;
+}
+
+void FrozenOctree::getSilhouttePotentialEdgesFromPoint(const glm::vec3& point, std::vector<int>& potential, std::vector<int>& silhouette) const
+{
+	SilhouetteEdgeCollector collector(potential, silhouette);
+	visitEdgesFromPoint(point, collector);
+}
+
+void FrozenOctree::visitEdgesFromPoint(const glm::vec3& point, SilhouetteEdgeVisitor& visitor) const
+{
+	if (!isValid() || !GeometryOps::testAabbPointIsInsideOrOn(_volume, point))
+		return;
+
+	int currentNode = 0;
+	AABB currentVolume = _volume;
+
+	while (currentNode >= 0)
+	{
+		visitNodeEdges(currentNode, visitor);
+
+		AABB childVolume;
+		unsigned int childIndex;
+		currentNode = _getChildContainingPoint(currentNode, currentVolume, point, childVolume, childIndex);
+		currentVolume = childVolume;
+	}
+}
+
+void FrozenOctree::getNodePathFromPoint(const glm::vec3& point, std::vector<unsigned int>& path) const
+{
+	path.clear();
+
+	if (!isValid() || !GeometryOps::testAabbPointIsInsideOrOn(_volume, point))
+		return;
+
+	int currentNode = 0;
+	AABB currentVolume = _volume;
+
+	while (currentNode >= 0)
+	{
+		path.push_back(currentNode);
+
+		AABB childVolume;
+		unsigned int childIndex;
+		currentNode = _getChildContainingPoint(currentNode, currentVolume, point, childVolume, childIndex);
+		currentVolume = childVolume;
+	}
+}
+
+unsigned int FrozenOctree::getNumNodes() const
+{
+	return _firstChild.size();
+}
+
+unsigned int FrozenOctree::getDeepestLevel() const
+{
+	return _levelStarts.empty() ? 0 : _levelStarts.size() - 1;
+}
+
+void FrozenOctree::getLevelNodeRange(unsigned int level, unsigned int& firstNode, unsigned int& numNodes) const
+{
+	if (level >= _levelStarts.size())
+	{
+		firstNode = numNodes = 0;
+		return;
+	}
+
+	firstNode = _levelStarts[level];
+	numNodes = ((level + 1) < _levelStarts.size() ? _levelStarts[level + 1] : getNumNodes()) - firstNode;
+}
+
+unsigned int FrozenOctree::getNumEdgesMayCast(unsigned int node) const
+{
+	if (isCompressed())
+	{
+		unsigned int numMayCast, numAlwaysCast;
+		_getCompressedEdgeListCounts(_nodeEdgeLists[node], numMayCast, numAlwaysCast);
+		return numMayCast;
+	}
+
+	return _edgesMayCastOffsets[_nodeEdgeLists[node] + 1] - _edgesMayCastOffsets[_nodeEdgeLists[node]];
+}
+
+unsigned int FrozenOctree::getNumEdgesAlwaysCast(unsigned int node) const
+{
+	if (isCompressed())
+	{
+		unsigned int numMayCast, numAlwaysCast;
+		_getCompressedEdgeListCounts(_nodeEdgeLists[node], numMayCast, numAlwaysCast);
+		return numAlwaysCast;
+	}
+
+	return _edgesAlwaysCastOffsets[_nodeEdgeLists[node] + 1] - _edgesAlwaysCastOffsets[_nodeEdgeLists[node]];
+}
+
+uint64_t FrozenOctree::getSizeBytes() const
+{
+	uint64_t sz = 0;
+
+	sz += _edgesMayCastPool.getSizeBytes();
+	sz += _edgesAlwaysCastPool.getSizeBytes();
+	sz += _edgesMayCastOffsets.getSizeBytes() + _edgesAlwaysCastOffsets.getSizeBytes();
+	sz += _firstChild.getSizeBytes();
+	sz += _childMask.getSizeBytes();
+	sz += _nodeEdgeLists.getSizeBytes();
+	sz += _splitPoints.getSizeBytes();
+	sz += _compressedEdges.getSizeBytes() + _compressedEdgesOffsets.getSizeBytes();
+
+	return sz;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Octree.hpp"
+#include "PackedArray.hpp"
+#include "StructureCache.hpp"
+#include "SilhouetteEdgeVisitor.hpp"
+
+#include <vector>
+#include <cstdint>
+
+//Nodes of a built octree in breadth-first order, existing children of each node in order
+class FrozenOctreeNodeSource
+{
+public:
+	struct SourceNode
+	{
+		unsigned int	nodeID;
+		unsigned int	level;
+		//Valid until the next node is requested
+		const Node*		node;
+		unsigned char	childMask;
+		glm::vec3		splitPoint;
+	};
+
+	virtual ~FrozenOctreeNodeSource() {}
+
+	virtual AABB getRootVolume() const = 0;
+	virtual unsigned int getDeepestLevel() const = 0;
+	virtual uint64_t getNumNodes() const = 0;
+
+	//Returns false once all nodes were returned
+	virtual bool getNextNode(SourceNode& sourceNode) = 0;
+};
+
+//Immutable, packed form of a built octree
+//Edge lists of all nodes are stored in two contiguous pools, addressed by per-list offsets (CSR layout)
+//Identical lists are stored once and identical subtrees are shared (DAG), nodes refer to their lists by index
+//Nodes are stored breadth-first, existing children of a node are stored next to each other
+//Split points are only stored for trees not split in the middle of each node
+//Optionally, the lists are compressed - each node then owns a byte range holding varint encoded
+//counts of potential, positive and negative silhouette edges, followed by the delta + varint encoded sorted lists
+class FrozenOctree
+{
+public:
+	FrozenOctree();
+
+	void freeze(const Octree& octree, bool compressEdgeLists = false);
+	//Same result as freezing the octree the nodes come from, without having it in memory
+	void freeze(FrozenOctreeNodeSource& nodeSource, bool compressEdgeLists = false);
+
+	void clear();
+
+	void save(StructureCacheWriter& writer) const;
+	//References the mapped cache memory, the reader's file has to be kept alive
+	bool load(StructureCacheReader& reader);
+
+	bool isValid() const;
+	bool isCompressed() const;
+
+	int getLowestNodeIndexFromPoint(const glm::vec3& point) const;
+	//Octree node ID of the deepest node containing the point, unlike the storage index it is unique even for shared subtrees
+	int getLowestNodeCellIDFromPoint(const glm::vec3& point) const;
+	void getSilhouttePotentialEdgesFromPoint(const glm::vec3& point, std::vector<int>& potential, std::vector<int>& silhouette) const;
+	//Nodes from the root down to the deepest existing node containing the point, empty if outside
+	void getNodePathFromPoint(const glm::vec3& point, std::vector<unsigned int>& path) const;
+	void getNodeEdges(unsigned int node, std::vector<int>& potential, std::vector<int>& silhouette) const;
+
+	//Never allocates, uncompressed lists are passed to the visitor directly
+	void visitEdgesFromPoint(const glm::vec3& point, SilhouetteEdgeVisitor& visitor) const;
+	void visitNodeEdges(unsigned int node, SilhouetteEdgeVisitor& visitor) const;
+
+	unsigned int getNumNodes() const;
+	unsigned int getDeepestLevel() const;
+	void getLevelNodeRange(unsigned int level, unsigned int& firstNode, unsigned int& numNodes) const;
+
+	unsigned int getNumEdgesMayCast(unsigned int node) const;
+	unsigned int getNumEdgesAlwaysCast(unsigned int node) const;
+
+	uint64_t getSizeBytes() const;
+
+private:
+	int _getChildContainingPoint(unsigned int node, const AABB& nodeVolume, const glm::vec3& point, AABB& childVolume, unsigned int& childIndex) const;
+
+	static void _mergeIdenticalSubtrees(std::vector<unsigned int>& firstChild, std::vector<unsigned char>& childMask, std::vector<unsigned int>& nodeEdgeLists, std::vector<glm::vec3>& splitPoints, std::vector<unsigned int>& levelStarts, bool compareSplitPoints);
+
+	static void _compressNodeEdges(const Node& node, std::vector<unsigned char>& compressedEdges);
+	void _visitCompressedEdgeList(unsigned int list, SilhouetteEdgeVisitor& visitor) const;
+	void _getCompressedEdgeListCounts(unsigned int list, unsigned int& numMayCast, unsigned int& numAlwaysCast) const;
+
+	AABB _volume;
+
+	PackedArray<unsigned int> _edgesMayCastPool;
+	PackedArray<int>		  _edgesAlwaysCastPool;
+
+	//List i owns pool range [offsets[i], offsets[i+1])
+	PackedArray<unsigned int> _edgesMayCastOffsets;
+	PackedArray<unsigned int> _edgesAlwaysCastOffsets;
+
+	//Indirection from nodes to their edge lists
+	PackedArray<unsigned int> _nodeEdgeLists;
+
+	//Children are addressed by the first child's index and a mask of existing children
+	PackedArray<unsigned int>  _firstChild;
+	PackedArray<unsigned char> _childMask;
+
+	PackedArray<unsigned int> _levelStarts;
+	PackedArray<glm::vec3>	  _splitPoints;
+
+	//Used instead of the pools when compressed, list i owns bytes [offsets[i], offsets[i+1])
+	PackedArray<unsigned char> _compressedEdges;
+	PackedArray<unsigned int>  _compressedEdgesOffsets;
+};
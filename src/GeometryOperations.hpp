@@ -2,7 +2,9 @@
 
 #include "AABB.hpp"
 #include "Plane.hpp"
+#include "RobustPredicates.hpp"
 #include "Edge.hpp"
+#include "EdgeStore.hpp"
 
 #include <vector>
 
@@ -43,34 +45,60 @@ namespace GeometryOps
 		return isInRange(point.x, minPoint.x, maxPoint.x) & isInRange(point.y, minPoint.y, maxPoint.y) & isInRange(point.z, minPoint.z, maxPoint.z);
 	}
 
-	inline TestResult interpretResult(float result)
+	//Largest sum of absolute coordinates of the box corners, scales the error bound of a FilteredPlane
+	inline float getAabbReach(const AABB& bbox)
 	{
-		TestResult r = TestResult::INTERSECTS_ON;
+		const glm::vec3 reach = glm::max(glm::abs(bbox.getMinPoint()), glm::abs(bbox.getMaxPoint()));
 
-		if (result > 0)
-			r = TestResult::ABOVE_OUTSIDE;
-		else if (result < 0)
-			r = TestResult::BELOW_INSIDE;
-
-		return r;
+		return reach.x + reach.y + reach.z;
 	}
 
-	inline TestResult testAabbPlane(const AABB& bbox, const Plane& plane)
+	//Exact side of the box, corners on the plane count as intersecting
+	//The plane has to be the one of the triangle v1, v2, v3, corners within its error bound are decided by orient3d
+	inline TestResult testAabbPlane(const AABB& bbox, const FilteredPlane& plane, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3)
 	{
-		glm::vec3 points[8];
-		bbox.getAllVertices(points);
+		const glm::vec3 minPoint = bbox.getMinPoint();
+		const glm::vec3 maxPoint = bbox.getMaxPoint();
+		const float errorBound = plane.errorScale * getAabbReach(bbox) + plane.errorOffset;
 
-		const TestResult result = interpretResult(testPlanePoint(plane, points[0]));
+		unsigned int numAbove = 0;
+		unsigned int numBelow = 0;
+		unsigned int uncertainCorners = 0;
 
-		for (unsigned int i = 1; i < 8; ++i)
+		for (unsigned int i = 0; i < 8; ++i)
 		{
-			TestResult r = interpretResult(testPlanePoint(plane, points[i]));
+			const glm::vec3 corner(i & 1 ? maxPoint.x : minPoint.x, i & 2 ? maxPoint.y : minPoint.y, i & 4 ? maxPoint.z : minPoint.z);
+			const float value = testPlanePoint(plane.plane, corner);
+
+			if (value > errorBound)
+				++numAbove;
+			else if (value < -errorBound)
+				++numBelow;
+			else
+				uncertainCorners |= 1 << i;
 
-			if (r != result)
+			if (numAbove && numBelow)
 				return TestResult::INTERSECTS_ON;
 		}
 
-		return result;
+		for (unsigned int i = 0; i < 8 && uncertainCorners; ++i)
+		{
+			if (!((uncertainCorners >> i) & 1))
+				continue;
+
+			const glm::vec3 corner(i & 1 ? maxPoint.x : minPoint.x, i & 2 ? maxPoint.y : minPoint.y, i & 4 ? maxPoint.z : minPoint.z);
+			const int side = RobustPredicates::orient3d(v2, v3, v1, corner);
+
+			if (side > 0)
+				++numAbove;
+			else if (side < 0)
+				++numBelow;
+
+			if (side == 0 || (numAbove && numBelow))
+				return TestResult::INTERSECTS_ON;
+		}
+
+		return numAbove ? TestResult::ABOVE_OUTSIDE : TestResult::BELOW_INSIDE;
 	}
 
 	inline int greaterVec(const glm::vec3& a, const glm::vec3& b)
@@ -78,13 +106,13 @@ namespace GeometryOps
 		return int(glm::dot(glm::vec3(glm::sign(a - b)), glm::vec3(4, 2, 1)));
 	}
 
-	inline int computeMult(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C, const glm::vec4& L) 
+	//Sign of dot(cross(C - A, L - A), B - A), exact
+	inline int computeMult(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C, const glm::vec3& L) 
 	{
-		glm::vec3 n = glm::cross(C - A, glm::vec3(L) - A*L.w);
-		return int(glm::sign(dot(n, B - A)));
+		return RobustPredicates::orient3d(A, B, C, L);
 	}
 
-	inline int currentMultiplicity(const glm::vec3& A, const glm::vec3& B, const glm::vec3& O, const glm::vec4& L) 
+	inline int currentMultiplicity(const glm::vec3& A, const glm::vec3& B, const glm::vec3& O, const glm::vec3& L) 
 	{
 		if (greaterVec(A, O)>0)
 			return computeMult(O, A, B, L);
@@ -94,23 +122,27 @@ namespace GeometryOps
 			return computeMult(A, B, O, L);
 	}
 
-	inline int calcEdgeMultiplicity(const EDGE_TYPE& edgeInfo, const glm::vec3& lightPos)
+	inline int calcEdgeMultiplicity(const EdgeStore& edges, unsigned int edgeID, const glm::vec3& lightPos)
 	{
-		const auto& edge = edgeInfo.first;
-		const auto& oppositeVertices = edgeInfo.second;
+		const glm::vec3& lowerPoint = edges.getLowerPoint(edgeID);
+		const glm::vec3& higherPoint = edges.getHigherPoint(edgeID);
+		const unsigned int numOppositeVertices = edges.getNumOppositeVertices(edgeID);
 
 		int multiplicity = 0;
-		const glm::vec4 L = glm::vec4(lightPos, 1);
-		for (const auto& oppositeVertex : oppositeVertices)
-			multiplicity += currentMultiplicity(edge.lowerPoint, edge.higherPoint, glm::vec3(oppositeVertex), L);
+		for (unsigned int i = 0; i < numOppositeVertices; ++i)
+			multiplicity += currentMultiplicity(lowerPoint, higherPoint, edges.getOppositeVertex(edgeID, i), lightPos);
 
 		return multiplicity;
 	}
 
-	inline EdgeSilhouetness testEdgeSpaceAabb(const Plane& p1, const Plane& p2, const EDGE_TYPE& edgeInfo, const AABB& voxel)
+	//Edge has to have two neighbouring triangles, their planes come from the store
+	inline EdgeSilhouetness testEdgeSpaceAabb(const EdgeStore& edges, unsigned int edgeID, const AABB& voxel)
 	{
-		auto result1 = testAabbPlane(voxel, p1);
-		auto result2 = testAabbPlane(voxel, p2);
+		const glm::vec3& lowerPoint = edges.getLowerPoint(edgeID);
+		const glm::vec3& higherPoint = edges.getHigherPoint(edgeID);
+
+		auto result1 = testAabbPlane(voxel, edges.getPlane(edgeID, 0), lowerPoint, edges.getOppositeVertex(edgeID, 0), higherPoint);
+		auto result2 = testAabbPlane(voxel, edges.getPlane(edgeID, 1), lowerPoint, edges.getOppositeVertex(edgeID, 1), higherPoint);
 
 		EdgeSilhouetness result = EdgeSilhouetness::EDGE_NOT_SILHOUETTE;
 
@@ -118,7 +150,7 @@ namespace GeometryOps
 			result = EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE;
 		else
 		{
-			int multiplicity = calcEdgeMultiplicity(edgeInfo, voxel.getMinPoint());
+			int multiplicity = calcEdgeMultiplicity(edges, edgeID, voxel.getMinPoint());
 
 			if (multiplicity > 0)
 				result = EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS;
@@ -129,8 +161,8 @@ namespace GeometryOps
 		return result;
 	}
 
-	inline void buildEdgeTrianglePlane(const Edge& edge, const glm::vec4& oppositeVertex, Plane& plane)
+	inline void buildEdgeTrianglePlane(const Edge& edge, const glm::vec3& oppositeVertex, FilteredPlane& plane)
 	{
-		plane.createFromPointsCCW(edge.lowerPoint, glm::vec3(oppositeVertex), edge.higherPoint);
+		plane.createFromPointsCCW(edge.lowerPoint, oppositeVertex, edge.higherPoint);
 	}
 };
\ No newline at end of file
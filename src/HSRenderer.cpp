@@ -11,7 +11,7 @@
 #include "GeometryOperations.hpp"
 #include "HighResolutionTimer.hpp"
 
-HierarchicalSilhouetteRenderer::HierarchicalSilhouetteRenderer()
+HierarchicalSilhouetteRenderer::HierarchicalSilhouetteRenderer() : _structureVersion(0), _isStructureComplete(false)
 {
 
 }
@@ -52,9 +52,9 @@ bool HierarchicalSilhouetteRenderer::init(std::shared_ptr<Scene> scene, unsigned
 	timer.reset();
 	//--
 	unsigned int badEdges = 0;
-	for(const auto& edge : _edges)
+	for(unsigned int i = 0; i < _edges.size(); ++i)
 	{
-		const auto s = edge.second.size();
+		const auto s = _edges.getNumOppositeVertices(i);
 
 		if (s == 0 || s > 2)
 			++badEdges;
@@ -65,7 +65,7 @@ bool HierarchicalSilhouetteRenderer::init(std::shared_ptr<Scene> scene, unsigned
 		params.numVoxelsX = params.numVoxelsY = params.numVoxelsZ = 30;
 
 		_silhouetteMethod = std::make_shared<BitArrayVoxelSilhouettes>();
-		_silhouetteMethod->initialize(_edges, _voxelSpace, &params);
+		_silhouetteMethod->initializeCached("voxels.cache", _edges, _voxelSpace, &params);
 
 		std::cout << "Bit array has size " << _silhouetteMethod->getAccelerationStructureSizeBytes() / 1024.0f / 1024.0f << "MB\n";
 	}
@@ -73,45 +73,34 @@ bool HierarchicalSilhouetteRenderer::init(std::shared_ptr<Scene> scene, unsigned
 	
 	
 	{
-		OctreeParams params;
-		params.maxDepthLevel = 5;
-
-		_silhouetteMethod = std::make_shared<OctreeSilhouettes>();
-		_silhouetteMethod->initialize(_edges, _voxelSpace, &params);
-		std::cout << "Octree has size " << _silhouetteMethod->getAccelerationStructureSizeBytes() / 1024.0f / 1024.0f << "MB\n";
-		
-		std::dynamic_pointer_cast<OctreeSilhouettes>(_silhouetteMethod)->printLevelOccupancies();
+		ProgressiveOctreeParams params;
+		params.octreeParams.maxDepthLevel = 5;
+		params.cachePath = "octree.cache";
+
+		//Loaded or built in the background, every edge is tested meanwhile
+		_progressiveMethod = std::make_shared<ProgressiveOctreeSilhouettes>();
+		_progressiveMethod->initialize(_edges, _voxelSpace, &params);
+		_silhouetteMethod = _progressiveMethod;
 	}
 	//*/
 
 	dt = timer.getElapsedTimeFromLastQueryMilliseconds();
 
-	std::cout << "Acceleration structure took " << dt / 1000.0f << " seconds to build\n";
+	std::cout << "Acceleration structure build started in " << dt << "ms\n";
 
 	if (!_initSidesRenderData())
 		return false;
 	
 	if (!_loadShaders())
 		return false;
-	
-	std::vector<int> potentialEdges;
-	std::vector<int> silhouetteEdges;
-
-	_silhouetteMethod->getSilhouetteEdgesForLightPos(_scene->lightPos, potentialEdges, silhouetteEdges);
-
-	std::cout << "Num potential: " << potentialEdges.size() << " num silhouette: " << silhouetteEdges.size() << std::endl;
-
-	_generateSidesFromEdgeIndices(potentialEdges, silhouetteEdges, _sides);
 
 	_edgeVisualizer.loadEdges(_edges);
 	
 	//--
-	_edges.clear();
 	_pretransformedTriangles.clear();
-	_scene.reset();
 	//--
 
-	_updateSides();
+	_updateSilhouette();
 	
 	//_initOctree();
 
@@ -128,7 +117,53 @@ void HierarchicalSilhouetteRenderer::_initGL(unsigned int screenWidth, unsigned
 
 void HierarchicalSilhouetteRenderer::onUpdate(float timeSinceLastUpdateMs)
 {
-	
+	if (_isStructureComplete || !_progressiveMethod)
+		return;
+
+	if (_progressiveMethod->getStructureVersion() != _structureVersion)
+		_updateSilhouette();
+}
+
+void HierarchicalSilhouetteRenderer::_updateSilhouette()
+{
+	//Methods built synchronously are complete right away
+	ProgressiveOctreeSilhouettes::CurrentMethod current = { _silhouetteMethod, _structureVersion, true };
+	if (_progressiveMethod)
+		current = _progressiveMethod->getCurrentMethod();
+
+	HighResolutionTimer timer;
+	timer.reset();
+
+	std::vector<int> potentialEdges;
+	std::vector<int> silhouetteEdges;
+
+	current.method->getSilhouetteEdgesForLightPos(_scene->lightPos, potentialEdges, silhouetteEdges);
+
+	std::cout << "Num potential: " << potentialEdges.size() << " num silhouette: " << silhouetteEdges.size() << std::endl;
+
+	_sides.clear();
+	_generateSidesFromEdgeIndices(potentialEdges, silhouetteEdges, _sides);
+	_updateSides();
+
+	std::cout << "Silhouette from structure version " << current.version << " took " << timer.getElapsedTimeFromLastQueryMilliseconds() << "ms\n";
+
+	_structureVersion = current.version;
+
+	if (!current.isComplete)
+		return;
+
+	_isStructureComplete = true;
+
+	std::cout << "Acceleration structure has size " << current.method->getAccelerationStructureSizeBytes() / 1024.0f / 1024.0f << "MB\n";
+
+	const auto octree = std::dynamic_pointer_cast<OctreeSilhouettes>(current.method);
+	if (octree)
+		octree->printLevelOccupancies();
+
+	//--
+	_edges.clear();
+	_scene.reset();
+	//--
 }
 
 void HierarchicalSilhouetteRenderer::onKeyPressed(SDL_Keycode code)
@@ -198,27 +233,28 @@ void HierarchicalSilhouetteRenderer::_generateSidesFromEdgeIndices(const std::ve
 	
 	for(const auto edge : silhouetteEdges)
 	{
-		//TODO tu opravit edge==0 moze mat len jednu orientaciu
-		
-		const int multiplicitySign = edge >= 0 ? 1 : -1;
-		_generatePushSideFromEdge(_scene->lightPos, _edges[abs(edge)].first, multiplicitySign, sides);
+		const int multiplicitySign = decodeSilhouetteEdgeSign(edge);
+		_generatePushSideFromEdge(_scene->lightPos, decodeSilhouetteEdgeID(edge), multiplicitySign, sides);
 		//*/
 		
 		/*
-		const int multiplicity = GeometryOps::calcEdgeMultiplicity(_edges[abs(edge)], _scene->lightPos);
+		const int multiplicity = GeometryOps::calcEdgeMultiplicity(_edges, decodeSilhouetteEdgeID(edge), _scene->lightPos);
 		if (multiplicity != 0)
 		{
-			_generatePushSideFromEdge(_scene->lightPos, _edges[abs(edge)].first, multiplicity, sides);
+			_generatePushSideFromEdge(_scene->lightPos, decodeSilhouetteEdgeID(edge), multiplicity, sides);
 		}
 		//*/
 	}
 	
-	for (const auto edge : potentialEdges)
+	_multiplicityEvaluator.computeMultiplicities(_edges, potentialEdges, _scene->lightPos, _potentialMultiplicities);
+
+	for (size_t i = 0; i < potentialEdges.size(); ++i)
 	{
-		const int multiplicity = GeometryOps::calcEdgeMultiplicity(_edges[edge], _scene->lightPos);
+		const int edge = potentialEdges[i];
+		const int multiplicity = _potentialMultiplicities[i];
 		if (multiplicity != 0)
 		{
-			_generatePushSideFromEdge(_scene->lightPos, _edges[edge].first, multiplicity, sides);
+			_generatePushSideFromEdge(_scene->lightPos, edge, multiplicity, sides);
 			++numSilhouetteEdges;
 			edges.push_back(edge);
 		}
@@ -236,30 +272,33 @@ void HierarchicalSilhouetteRenderer::_generateSidesFromEdgeIndices(const std::ve
 	//--
 }
 
-void HierarchicalSilhouetteRenderer::_generatePushSideFromEdge(const glm::vec3& lightPos, const Edge& edge, int multiplicitySign, std::vector<glm::vec4>& sides) const
+void HierarchicalSilhouetteRenderer::_generatePushSideFromEdge(const glm::vec3& lightPos, unsigned int edgeID, int multiplicitySign, std::vector<glm::vec4>& sides) const
 {
-	glm::vec4 lowInfinity = glm::vec4(edge.lowerPoint - lightPos, 0);
-	glm::vec4 highInfinity = glm::vec4(edge.higherPoint - lightPos, 0);
+	const glm::vec3& lowerPoint = _edges.getLowerPoint(edgeID);
+	const glm::vec3& higherPoint = _edges.getHigherPoint(edgeID);
+
+	glm::vec4 lowInfinity = glm::vec4(lowerPoint - lightPos, 0);
+	glm::vec4 highInfinity = glm::vec4(higherPoint - lightPos, 0);
 
 	if (multiplicitySign < 0)
 	{
 		sides.push_back(lowInfinity);
-		sides.push_back(glm::vec4(edge.lowerPoint, 1));
-		sides.push_back(glm::vec4(edge.higherPoint, 1));
+		sides.push_back(glm::vec4(lowerPoint, 1));
+		sides.push_back(glm::vec4(higherPoint, 1));
 
 		sides.push_back(highInfinity);
 		sides.push_back(lowInfinity);
-		sides.push_back(glm::vec4(edge.higherPoint, 1));
+		sides.push_back(glm::vec4(higherPoint, 1));
 	}
 	else if(multiplicitySign > 0)
 	{
 		sides.push_back(highInfinity);
-		sides.push_back(glm::vec4(edge.higherPoint, 1));
-		sides.push_back(glm::vec4(edge.lowerPoint, 1));
+		sides.push_back(glm::vec4(higherPoint, 1));
+		sides.push_back(glm::vec4(lowerPoint, 1));
 
 		sides.push_back(lowInfinity);
 		sides.push_back(highInfinity);
-		sides.push_back(glm::vec4(edge.lowerPoint, 1));
+		sides.push_back(glm::vec4(lowerPoint, 1));
 	}
 }
 
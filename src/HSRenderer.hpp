@@ -6,7 +6,7 @@
 #include <GL/glew.h>
 
 #include "Scene.hpp"
-#include "Edge.hpp"
+#include "EdgeStore.hpp"
 #include "Plane.hpp"
 #include "Triangle.hpp"
 #include "MultiBitArray.hpp"
@@ -17,6 +17,8 @@
 #include "OctreeVisitor.hpp"
 #include "BitArrayVoxelSilhouettes.hpp"
 #include "OctreeSilhouettes.hpp"
+#include "ProgressiveOctreeSilhouettes.hpp"
+#include "EdgeMultiplicityEvaluator.hpp"
 
 class HierarchicalSilhouetteRenderer
 {
@@ -45,10 +47,12 @@ private:
 
 	//Sides generator
 	void _generateSidesFromEdgeIndices(const std::vector<int>& potentialEdges, const std::vector<int>& silhouetteEdges, std::vector<glm::vec4>& sides);
-	void _generatePushSideFromEdge(const glm::vec3& lightPos, const Edge& edge, int multiplicitySign, std::vector<glm::vec4>& sides) const;
+	void _generatePushSideFromEdge(const glm::vec3& lightPos, unsigned int edgeID, int multiplicitySign, std::vector<glm::vec4>& sides) const;
 
 	//Shadow volume rendering
 	void _updateSides();
+	//Regenerates the sides with the structure the silhouette method has now
+	void _updateSilhouette();
 
 	void _visualizeSides(const glm::mat4& mvp);
 	void _visualizeEdges(const glm::mat4& mvp);
@@ -83,10 +87,19 @@ private:
 
 	std::shared_ptr<Scene> _scene;
 
-	EDGE_CONTAINER_TYPE _edges;
+	EdgeStore _edges;
 	std::vector<Triangle> _pretransformedTriangles;
 
 	std::vector<glm::vec4> _sides;
 
+	EdgeMultiplicityEvaluator _multiplicityEvaluator;
+	//Kept between frames to avoid reallocating
+	std::vector<int> _potentialMultiplicities;
+
 	std::shared_ptr<AbstractSilhouetteMethod> _silhouetteMethod;
+	//Same object as _silhouetteMethod when it is built in the background, empty otherwise
+	std::shared_ptr<ProgressiveOctreeSilhouettes> _progressiveMethod;
+	//Version of the progressively built structure the sides come from
+	unsigned int _structureVersion;
+	bool _isStructureComplete;
 };
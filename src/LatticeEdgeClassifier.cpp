@@ -0,0 +1,165 @@
+#include "LatticeEdgeClassifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+LatticeEdgeClassifier::LatticeEdgeClassifier()
+{
+	for (unsigned int axis = 0; axis < LATTICE_CLASSIFIER_NUM_AXES; ++axis)
+		_axes[axis].maxReach = 0;
+}
+
+void LatticeEdgeClassifier::setAxis(unsigned int axis, const std::vector<float>& lower, const std::vector<float>& upper)
+{
+	assert(axis < LATTICE_CLASSIFIER_NUM_AXES && lower.size() == upper.size());
+
+	Axis& a = _axes[axis];
+	a.lower = lower;
+	a.upper = upper;
+	a.reach.resize(lower.size());
+	a.maxReach = 0;
+
+	for (size_t i = 0; i < lower.size(); ++i)
+	{
+		a.reach[i] = std::max(std::abs(lower[i]), std::abs(upper[i]));
+		a.maxReach = std::max(a.maxReach, a.reach[i]);
+	}
+
+	_terms[axis].nearTerms.resize(lower.size());
+	_terms[axis].farTerms.resize(lower.size());
+
+	for (unsigned int i = 0; i < EDGE_STORE_NUM_OPPOSITE_SLOTS; ++i)
+		_sides[i].resize(getNumCells());
+}
+
+unsigned int LatticeEdgeClassifier::getNumCells(unsigned int axis) const
+{
+	return unsigned(_axes[axis].lower.size());
+}
+
+unsigned int LatticeEdgeClassifier::getNumCells() const
+{
+	return getNumCells(0) * getNumCells(1) * getNumCells(2);
+}
+
+AABB LatticeEdgeClassifier::getCellVolume(unsigned int x, unsigned int y, unsigned int z) const
+{
+	return AABB(glm::vec3(_axes[0].lower[x], _axes[1].lower[y], _axes[2].lower[z]), glm::vec3(_axes[0].upper[x], _axes[1].upper[y], _axes[2].upper[z]));
+}
+
+void LatticeEdgeClassifier::classifyEdge(const EdgeStore& edges, unsigned int edgeID, EdgeSilhouetness* results)
+{
+	_classifyPlane(edges.getPlane(edgeID, 0), _sides[0]);
+	_classifyPlane(edges.getPlane(edgeID, 1), _sides[1]);
+
+	const unsigned int numX = getNumCells(0);
+	const unsigned int numY = getNumCells(1);
+	const unsigned int numZ = getNumCells(2);
+
+	unsigned int cell = 0;
+
+	for (unsigned int z = 0; z < numZ; ++z)
+	{
+		for (unsigned int y = 0; y < numY; ++y)
+		{
+			for (unsigned int x = 0; x < numX; ++x, ++cell)
+			{
+				const uint8_t side1 = _sides[0][cell];
+				const uint8_t side2 = _sides[1][cell];
+
+				if (side1 == SIDE_CROSSING || side2 == SIDE_CROSSING)
+					results[cell] = EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE;
+				else if (side1 == SIDE_UNCERTAIN || side2 == SIDE_UNCERTAIN)
+					results[cell] = GeometryOps::testEdgeSpaceAabb(edges, edgeID, getCellVolume(x, y, z));
+				else
+				{
+					//computeMult of a triangle has the opposite sign of the side of its plane the light is on
+					const int multiplicity = (side1 == SIDE_BELOW) + (side2 == SIDE_BELOW) - (side1 == SIDE_ABOVE) - (side2 == SIDE_ABOVE);
+
+					if (multiplicity > 0)
+						results[cell] = EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS;
+					else if (multiplicity < 0)
+						results[cell] = EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS;
+					else
+						results[cell] = EdgeSilhouetness::EDGE_NOT_SILHOUETTE;
+				}
+			}
+		}
+	}
+}
+
+void LatticeEdgeClassifier::_classifyPlane(const FilteredPlane& plane, std::vector<uint8_t>& sides)
+{
+	const glm::vec4& eq = plane.plane.equation;
+
+	//Rounding of the products is monotonic, so the near and far terms stay the extremes of each interval
+	for (unsigned int axis = 0; axis < LATTICE_CLASSIFIER_NUM_AXES; ++axis)
+	{
+		const Axis& a = _axes[axis];
+		AxisTerms& terms = _terms[axis];
+		const float coefficient = eq[axis];
+		const size_t numIntervals = a.lower.size();
+
+		terms.minNearTerm = std::numeric_limits<float>::infinity();
+		terms.maxFarTerm = -std::numeric_limits<float>::infinity();
+
+		for (size_t i = 0; i < numIntervals; ++i)
+		{
+			const float lowerTerm = coefficient * a.lower[i];
+			const float upperTerm = coefficient * a.upper[i];
+
+			terms.nearTerms[i] = coefficient > 0 ? lowerTerm : upperTerm;
+			terms.farTerms[i] = coefficient > 0 ? upperTerm : lowerTerm;
+			terms.minNearTerm = std::min(terms.minNearTerm, terms.nearTerms[i]);
+			terms.maxFarTerm = std::max(terms.maxFarTerm, terms.farTerms[i]);
+		}
+	}
+
+	const AxisTerms& termsX = _terms[0];
+	const unsigned int numX = getNumCells(0);
+	const unsigned int numY = getNumCells(1);
+	const unsigned int numZ = getNumCells(2);
+
+	uint8_t* row = sides.data();
+
+	//The bound of a FilteredPlane does not depend on the order of the additions, the row part is summed first
+	for (unsigned int z = 0; z < numZ; ++z)
+	{
+		for (unsigned int y = 0; y < numY; ++y, row += numX)
+		{
+			const float nearRow = (_terms[1].nearTerms[y] + _terms[2].nearTerms[z]) + eq.w;
+			const float farRow = (_terms[1].farTerms[y] + _terms[2].farTerms[z]) + eq.w;
+			//Largest reach of the row's cells
+			const float errorBound = plane.errorScale * ((_axes[0].maxReach + _axes[1].reach[y]) + _axes[2].reach[z]) + plane.errorOffset;
+
+			if (termsX.minNearTerm + nearRow > errorBound)
+			{
+				std::fill(row, row + numX, uint8_t(SIDE_ABOVE));
+				continue;
+			}
+
+			if (termsX.maxFarTerm + farRow < -errorBound)
+			{
+				std::fill(row, row + numX, uint8_t(SIDE_BELOW));
+				continue;
+			}
+
+			for (unsigned int x = 0; x < numX; ++x)
+			{
+				const float lowest = termsX.nearTerms[x] + nearRow;
+				const float highest = termsX.farTerms[x] + farRow;
+
+				if (lowest > errorBound)
+					row[x] = SIDE_ABOVE;
+				else if (highest < -errorBound)
+					row[x] = SIDE_BELOW;
+				else if (lowest < -errorBound && highest > errorBound)
+					row[x] = SIDE_CROSSING;
+				else
+					row[x] = SIDE_UNCERTAIN;
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GeometryOperations.hpp"
+
+#include <vector>
+#include <cstdint>
+
+#define LATTICE_CLASSIFIER_NUM_AXES 3
+
+//Tests one edge against a whole grid of cells, with the same results as testEdgeSpaceAabb for each cell
+//Cells are products of intervals along the axes, so a plane is evaluated per axis once and a cell costs two additions:
+//the interval term nearest along the normal plus the row's near term, and the same for the farthest corner
+//Rows entirely on one side of a plane are filled without visiting their cells
+class LatticeEdgeClassifier
+{
+public:
+	LatticeEdgeClassifier();
+
+	//Interval i of the axis is [lower[i], upper[i]]
+	void setAxis(unsigned int axis, const std::vector<float>& lower, const std::vector<float>& upper);
+
+	unsigned int getNumCells(unsigned int axis) const;
+	unsigned int getNumCells() const;
+
+	//Cell (x, y, z) has the index x + numX * (y + numY * z)
+	AABB getCellVolume(unsigned int x, unsigned int y, unsigned int z) const;
+
+	//Edge has to have two neighbouring triangles, results are indexed like the cells
+	void classifyEdge(const EdgeStore& edges, unsigned int edgeID, EdgeSilhouetness* results);
+
+private:
+	//Side of a cell certified by the plane's error bound, uncertain cells need testEdgeSpaceAabb
+	enum Side : uint8_t
+	{
+		SIDE_UNCERTAIN = 0,
+		SIDE_ABOVE = 1,
+		SIDE_BELOW = 2,
+		SIDE_CROSSING = 3
+	};
+
+	struct Axis
+	{
+		std::vector<float>	lower;
+		std::vector<float>	upper;
+		//max(|lower|, |upper|) of each interval, scales the error bound of the plane
+		std::vector<float>	reach;
+		float				maxReach;
+	};
+
+	//Plane terms of the interval ends nearest and farthest along the normal
+	struct AxisTerms
+	{
+		std::vector<float>	nearTerms;
+		std::vector<float>	farTerms;
+		float				minNearTerm;
+		float				maxFarTerm;
+	};
+
+	void _classifyPlane(const FilteredPlane& plane, std::vector<uint8_t>& sides);
+
+	Axis					_axes[LATTICE_CLASSIFIER_NUM_AXES];
+
+	AxisTerms				_terms[LATTICE_CLASSIFIER_NUM_AXES];
+	std::vector<uint8_t>	_sides[EDGE_STORE_NUM_OPPOSITE_SLOTS];
+};
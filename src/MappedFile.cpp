@@ -0,0 +1,124 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+#ifdef _WIN32
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_mappingHandle = nullptr;
+#else
+	_fileDescriptor = -1;
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_mappingHandle)
+	{
+		close();
+		return false;
+	}
+
+	_data = reinterpret_cast<const unsigned char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	_size = uint64_t(fileSize.QuadPart);
+#else
+	_fileDescriptor = ::open(path.c_str(), O_RDONLY);
+	if (_fileDescriptor < 0)
+		return false;
+
+	struct stat fileStats;
+	if (fstat(_fileDescriptor, &fileStats) != 0 || fileStats.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, size_t(fileStats.st_size), PROT_READ, MAP_SHARED, _fileDescriptor, 0);
+	_data = mapping == MAP_FAILED ? nullptr : reinterpret_cast<const unsigned char*>(mapping);
+	_size = uint64_t(fileStats.st_size);
+#endif
+
+	if (!_data)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (_data)
+		UnmapViewOfFile(_data);
+
+	if (_mappingHandle)
+		CloseHandle(_mappingHandle);
+
+	if (_fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(_fileHandle);
+
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_mappingHandle = nullptr;
+#else
+	if (_data)
+		munmap(const_cast<unsigned char*>(_data), size_t(_size));
+
+	if (_fileDescriptor >= 0)
+		::close(_fileDescriptor);
+
+	_fileDescriptor = -1;
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return _data != nullptr;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return _data;
+}
+
+uint64_t MappedFile::getSize() const
+{
+	return _size;
+}
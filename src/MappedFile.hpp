@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+//Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const;
+
+	const unsigned char* getData() const;
+	uint64_t getSize() const;
+
+private:
+
+#ifdef _WIN32
+	void* _fileHandle;
+	void* _mappingHandle;
+#else
+	int   _fileDescriptor;
+#endif
+
+	const unsigned char* _data;
+	uint64_t			 _size;
+};
@@ -61,6 +61,47 @@ unsigned int MultiBitArray::getNumCells() const
 	return _numCells;
 }
 
+const uint32_t* MultiBitArray::getData() const
+{
+	return _array.data();
+}
+
+unsigned int MultiBitArray::getArraySize() const
+{
+	return _array.size();
+}
+
+uint32_t MultiBitArray::getCellContent(const uint32_t* array, unsigned int numBitsPerCell, unsigned int cellIndex)
+{
+	assert(numBitsPerCell < MBA_ARRAY_ITEM_SIZE);
+
+	const uint64_t startBit = uint64_t(cellIndex) * numBitsPerCell;
+	const uint64_t arrayIndex = startBit / MBA_ARRAY_ITEM_SIZE;
+	const unsigned int startPosition = startBit % MBA_ARRAY_ITEM_SIZE;
+
+	uint64_t bits = array[arrayIndex];
+	if ((startPosition + numBitsPerCell) > MBA_ARRAY_ITEM_SIZE)
+		bits |= uint64_t(array[arrayIndex + 1]) << MBA_ARRAY_ITEM_SIZE;
+
+	return uint32_t((bits >> startPosition) & ((uint64_t(1) << numBitsPerCell) - 1));
+}
+
+void MultiBitArray::setCellContent(uint32_t* array, unsigned int numBitsPerCell, unsigned int cellIndex, uint32_t value)
+{
+	assert(numBitsPerCell < MBA_ARRAY_ITEM_SIZE);
+
+	const uint64_t startBit = uint64_t(cellIndex) * numBitsPerCell;
+	const uint64_t arrayIndex = startBit / MBA_ARRAY_ITEM_SIZE;
+	const unsigned int startPosition = startBit % MBA_ARRAY_ITEM_SIZE;
+
+	const uint64_t mask = ((uint64_t(1) << numBitsPerCell) - 1) << startPosition;
+	const uint64_t bits = (uint64_t(value) << startPosition) & mask;
+
+	array[arrayIndex] = (array[arrayIndex] & ~uint32_t(mask)) | uint32_t(bits);
+	if ((startPosition + numBitsPerCell) > MBA_ARRAY_ITEM_SIZE)
+		array[arrayIndex + 1] = (array[arrayIndex + 1] & ~uint32_t(mask >> MBA_ARRAY_ITEM_SIZE)) | uint32_t(bits >> MBA_ARRAY_ITEM_SIZE);
+}
+
 uint32_t MultiBitArray::getCellContent(unsigned int cellIndex) const
 {
 	assert(cellIndex < _numCells);
@@ -22,6 +22,14 @@ public:
 	unsigned int getNumBitsPerCell() const;
 	unsigned int getNumCells() const;
 
+	const uint32_t* getData() const;
+	unsigned int getArraySize() const;
+
+	//Reads a cell from packed array data laid out like MultiBitArray's
+	static uint32_t getCellContent(const uint32_t* array, unsigned int numBitsPerCell, unsigned int cellIndex);
+	//Writes a cell to packed array data laid out like MultiBitArray's
+	static void setCellContent(uint32_t* array, unsigned int numBitsPerCell, unsigned int cellIndex, uint32_t value);
+
 	void free();
 	
 private:
@@ -2,66 +2,73 @@
 
 #include "GeometryOperations.hpp"
 
-int ipow(int base, int exp)
-{
-	int result = 1;
-	while (exp)
-	{
-		if (exp & 1)
-			result *= base;
-		exp >>= 1;
-		base *= base;
-	}
-
-	return result;
-}
-
 Octree::Octree(unsigned int deepestLevel, const AABB& volume)
 {
-	_deepestLevel = deepestLevel;
+	assert(deepestLevel <= OCTREE_MAX_DEPTH);
 
-	_generateLevelSizes();
+	_deepestLevel = deepestLevel;
 
 	_init(volume);
 }
 
-void Octree::_generateLevelSizes()
-{
-	_levelSizesInclusiveSum.clear();
-
-	unsigned int prefixSum = 0;
-
-	for(unsigned int i=0; i<= _deepestLevel; ++i)
-	{
-		const unsigned int levelSize = ipow(OCTREE_NUM_CHILDREN, i);
-		_levelSizesInclusiveSum.push_back(levelSize + prefixSum);
-		prefixSum += levelSize;
-	}
-}
-
 void Octree::_init(const AABB& volume)
 {
 	Node n;
 	n.volume = volume;
 
-	_nodes.resize(getTotalNumNodes());
-	_nodes[0] = n;
+	_volume = volume;
+
+	_levels.clear();
+	_levels.resize(_deepestLevel + 1);
+	_levels[0][0] = n;
 }
 
 Node* Octree::getNode(unsigned int nodeID)
 {
-	if (nodeID > getTotalNumNodes() || !_nodes[nodeID].volume.isValid())
+	if (nodeID >= getTotalNumNodes())
+		return nullptr;
+
+	const int level = getNodeRecursionLevel(nodeID);
+	auto it = _levels[level].find(getNodeIdInLevel(nodeID, level));
+
+	if (it == _levels[level].end())
 		return nullptr;
 
-	return &(_nodes[nodeID]);
+	return &(it->second);
 }
 
 const Node* Octree::getNode(unsigned int nodeID) const
 {
-	if (nodeID > getTotalNumNodes() || !_nodes[nodeID].volume.isValid())
+	if (nodeID >= getTotalNumNodes())
 		return nullptr;
 
-	return &(_nodes[nodeID]);
+	const int level = getNodeRecursionLevel(nodeID);
+	const auto it = _levels[level].find(getNodeIdInLevel(nodeID, level));
+
+	if (it == _levels[level].end())
+		return nullptr;
+
+	return &(it->second);
+}
+
+Node* Octree::materializeNode(unsigned int nodeID)
+{
+	Node* node = getNode(nodeID);
+
+	if (node)
+		return node;
+
+	//Ancestors of a materialized node always exist, point queries descend through them
+	const int parent = getNodeParent(nodeID);
+	if (parent >= 0)
+		materializeNode(parent);
+
+	const int level = getNodeRecursionLevel(nodeID);
+
+	Node& n = _levels[level][getNodeIdInLevel(nodeID, level)];
+	n.volume = calculateNodeVolume(nodeID);
+
+	return &n;
 }
 
 AABB Octree::getNodeVolume(unsigned int nodeID) const
@@ -76,34 +83,36 @@ AABB Octree::getNodeVolume(unsigned int nodeID) const
 	return AABB();
 }
 
-int Octree::getNodeParent(unsigned int nodeID) const
+AABB Octree::calculateNodeVolume(unsigned int nodeID) const
 {
-	if (nodeID == 0)
-		return -1;
-	
-	const int nodeLevel = getNodeRecursionLevel(nodeID);
-	
-	assert(nodeLevel >= 0);
+	//Does not touch node storage, so it is safe to call while other threads materialize nodes
+	const int level = getNodeRecursionLevel(nodeID);
+
+	assert(level >= 0);
 
-	const int idInLevel = getNodeIdInLevel(nodeID, nodeLevel);
+	const unsigned int mortonCode = getNodeIdInLevel(nodeID, level);
 
-	const int parentRelativeID = idInLevel / OCTREE_NUM_CHILDREN;
+	AABB volume = _volume;
+	for (int l = level - 1; l >= 0; --l)
+		volume = getChildVolume(volume, (mortonCode >> (3 * l)) & (OCTREE_NUM_CHILDREN - 1));
 
-	return parentRelativeID + getNumNodesInPreviousLevels(nodeLevel - 1);
+	return volume;
 }
 
-int Octree::getNodeRecursionLevel(unsigned int nodeID) const
+int Octree::getNodeParent(unsigned int nodeID) const
 {
-	int level = 0;
-	for(auto size : _levelSizesInclusiveSum)
-	{
-		if (nodeID < size)
-			return level;
+	if (nodeID == 0 || nodeID >= getTotalNumNodes())
+		return -1;
 
-		++level;
-	}
+	return NodeAddressing::getNodeParent(nodeID);
+}
+
+int Octree::getNodeRecursionLevel(unsigned int nodeID) const
+{
+	if (nodeID >= getTotalNumNodes())
+		return -1;
 
-	return -1;
+	return NodeAddressing::getNodeLevel(nodeID);
 }
 
 int Octree::getNodeIdInLevel(unsigned int nodeID) const
@@ -115,7 +124,7 @@ int Octree::getNodeIdInLevel(unsigned int nodeID) const
 
 int Octree::getNodeIdInLevel(unsigned int nodeID, unsigned int level) const
 {
-	return nodeID - getNumNodesInPreviousLevels(level);
+	return nodeID - NodeAddressing::getLevelFirstNodeID(level);
 }
 
 int Octree::getLowestLevelCellIndexFromPointInSpace(const glm::vec3& point)
@@ -126,15 +135,14 @@ int Octree::getLowestLevelCellIndexFromPointInSpace(const glm::vec3& point)
 	unsigned int currentLevel = 0;
 	unsigned int currentNode = 0;
 	
-	while(currentLevel <= _deepestLevel)
+	while(currentLevel < _deepestLevel)
 	{
 		const int startingChild = getChildrenStartingId(currentNode);
+		const int childIndex = _getCorrespondingChildIndexFromPoint(currentNode, point);
 
-		if (!nodeExists(startingChild))
+		if (!nodeExists(startingChild + childIndex))
 			break;
 
-		const int childIndex = _getCorrespondingChildIndexFromPoint(currentNode, point);
-
 		currentNode = startingChild + childIndex;
 		++currentLevel;
 	}
@@ -144,7 +152,7 @@ int Octree::getLowestLevelCellIndexFromPointInSpace(const glm::vec3& point)
 
 int Octree::_getCorrespondingChildIndexFromPoint(unsigned int nodeID, const glm::vec3& point) const
 {
-	const glm::vec3 centerPoint = getNodeVolume(nodeID).getCenterPoint();
+	const glm::vec3 centerPoint = getNodeSplitPoint(nodeID);
 
 	int r = (point.x >= centerPoint.x) + 2 * (point.y >= centerPoint.y) + 4 * (point.z >= centerPoint.z);
 	return r;
@@ -152,17 +160,26 @@ int Octree::_getCorrespondingChildIndexFromPoint(unsigned int nodeID, const glm:
 
 bool Octree::nodeExists(unsigned int nodeID) const
 {
-	return (nodeID < getTotalNumNodes()) && _nodes[nodeID].volume.isValid();
+	return getNode(nodeID) != nullptr;
 }
 
 bool Octree::childrenExist(unsigned int nodeID) const
 {
-	int startID = getChildrenStartingId(nodeID);
+	if (getNodeRecursionLevel(nodeID) >= int(_deepestLevel))
+		return false;
+
+	const int startID = getChildrenStartingId(nodeID);
 
 	if (startID < 0)
 		return false;
 
-	return nodeExists(startID);
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		if (nodeExists(startID + i))
+			return true;
+	}
+
+	return false;
 }
 
 void Octree::splitNode(unsigned int nodeID)
@@ -177,12 +194,15 @@ void Octree::splitNode(unsigned int nodeID)
 
 void Octree::deleteNode(unsigned int nodeID)
 {
-	_nodes[nodeID].clear();
+	const int level = getNodeRecursionLevel(nodeID);
+
+	if (level >= 0)
+		_levels[level].erase(getNodeIdInLevel(nodeID, level));
 }
 
 void Octree::deleteNodeSubtree(unsigned nodeID)
 {
-	_nodes[nodeID].clear();
+	deleteNode(nodeID);
 
 	const int level = getNodeRecursionLevel(nodeID);
 
@@ -191,36 +211,22 @@ void Octree::deleteNodeSubtree(unsigned nodeID)
 		const unsigned int startingChild = getChildrenStartingId(nodeID);
 
 		for (unsigned int i = startingChild; i < (startingChild + OCTREE_NUM_CHILDREN); ++i)
-			deleteNodeSubtree(i);
+		{
+			if (nodeExists(i))
+				deleteNodeSubtree(i);
+		}
 	}
 }
 
-unsigned int Octree::getNumNodesInPreviousLevels(int level) const
-{
-	const int l = level - 1;
-
-	assert(l < int(_levelSizesInclusiveSum.size()));
-
-	if (l < 0 || l> (int)_deepestLevel)
-		return 0;
-
-	return _levelSizesInclusiveSum[l];
-}
-
 int Octree::getChildrenStartingId(unsigned int nodeID) const
 {
 	const int nodeLevel = getNodeRecursionLevel(nodeID);
 
-	if (nodeLevel > _deepestLevel)
+	//Nodes on the deepest level have no children
+	if (nodeLevel < 0 || nodeLevel >= int(_deepestLevel))
 		return -1;
 
-	assert((nodeLevel >= 0) && nodeLevel<=(int)_deepestLevel);
-
-	const int idInLevel = getNodeIdInLevel(nodeID, nodeLevel);
-
-	assert(idInLevel >= 0);
-
-	return OCTREE_NUM_CHILDREN*idInLevel + _levelSizesInclusiveSum[nodeLevel];
+	return NodeAddressing::getChildrenStartingID(nodeID);
 }
 
 void Octree::_createChild(const AABB& parentSpace, unsigned int newNodeId, unsigned int indexWithinParent)
@@ -228,36 +234,66 @@ void Octree::_createChild(const AABB& parentSpace, unsigned int newNodeId, unsig
 	assert(!nodeExists(newNodeId));
 
 	Node n;
+	n.volume = getChildVolume(parentSpace, indexWithinParent);
+
+	const int level = getNodeRecursionLevel(newNodeId);
+	_levels[level][getNodeIdInLevel(newNodeId, level)] = n;
+}
+
+AABB Octree::getChildVolume(const AABB& parentSpace, unsigned int indexWithinParent)
+{
+	//Children keep the parent's outer faces and meet at its center, adding half extents twice could round past the parent
+	return getChildVolume(parentSpace, indexWithinParent, parentSpace.getCenterPoint());
+}
+
+AABB Octree::getChildVolume(const AABB& parentSpace, unsigned int indexWithinParent, const glm::vec3& splitPoint)
+{
 	glm::vec3 minPoint = parentSpace.getMinPoint();
+	glm::vec3 maxPoint = parentSpace.getMaxPoint();
 
-	const bool isInPlusX = (indexWithinParent & 1) != 0;
-	const bool isInPlusY = (indexWithinParent & 2) != 0;
-	const bool isInPlusZ = (indexWithinParent & 4) != 0;
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		if (indexWithinParent & (1 << axis))
+			minPoint[axis] = splitPoint[axis];
+		else
+			maxPoint[axis] = splitPoint[axis];
+	}
 
-	float parentHalfExtentX, parentHalfExtentY, parentHalfExtentZ;
-	parentSpace.getExtents(parentHalfExtentX, parentHalfExtentY,parentHalfExtentZ);
+	return AABB(minPoint, maxPoint);
+}
 
-	parentHalfExtentX /= 2.0f;
-	parentHalfExtentY /= 2.0f;
-	parentHalfExtentZ /= 2.0f;
+glm::vec3 Octree::getNodeSplitPoint(unsigned int nodeID) const
+{
+	const int startingChild = getChildrenStartingId(nodeID);
 
-	glm::vec3 minPointOffset = glm::vec3(isInPlusX * parentHalfExtentX, isInPlusY * parentHalfExtentY, isInPlusZ * parentHalfExtentZ);
+	//Derived from any existing child, nodes without children are split in the middle
+	for (unsigned int i = 0; startingChild >= 0 && i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		const Node* child = getNode(startingChild + i);
 
-	minPoint = minPoint + minPointOffset;
-	glm::vec3 maxPoint = minPoint + glm::vec3(parentHalfExtentX, parentHalfExtentY, parentHalfExtentZ);
+		if (!child)
+			continue;
 
-	n.volume = AABB(minPoint, maxPoint);
+		return getSplitPointFromChild(child->volume, i);
+	}
 
-	_nodes[newNodeId] = n;
+	return getNodeVolume(nodeID).getCenterPoint();
 }
 
-int Octree::getNodeIndexWithinParent(unsigned int nodeID) const
+glm::vec3 Octree::getSplitPointFromChild(const AABB& childVolume, unsigned int indexWithinParent)
 {
-	const int parent = getNodeParent(nodeID);
+	glm::vec3 splitPoint;
+	for (unsigned int axis = 0; axis < 3; ++axis)
+		splitPoint[axis] = (indexWithinParent & (1 << axis)) ? childVolume.getMinPoint()[axis] : childVolume.getMaxPoint()[axis];
 
-	assert(parent >= 0);
+	return splitPoint;
+}
+
+int Octree::getNodeIndexWithinParent(unsigned int nodeID) const
+{
+	assert(nodeID > 0 && nodeID < getTotalNumNodes());
 
-	return getNodeIndexWithinParent(nodeID, parent);
+	return NodeAddressing::getNodeIndexWithinParent(nodeID);
 }
 
 int Octree::getNodeIndexWithinParent(unsigned int nodeID, unsigned int parent) const
@@ -269,7 +305,7 @@ int Octree::getNodeIndexWithinParent(unsigned int nodeID, unsigned int parent) c
 
 bool Octree::_isPointInsideOctree(const glm::vec3& point) const
 {
-	return GeometryOps::testAabbPointIsInsideOrOn(_nodes[0].volume, point);
+	return GeometryOps::testAabbPointIsInsideOrOn(_volume, point);
 }
 
 unsigned int Octree::getDeepestLevel() const
@@ -279,7 +315,33 @@ unsigned int Octree::getDeepestLevel() const
 
 unsigned int Octree::getTotalNumNodes() const
 {
-	return _levelSizesInclusiveSum[_deepestLevel];
+	return NodeAddressing::getLevelFirstNodeID(_deepestLevel + 1);
+}
+
+uint64_t Octree::getNumMaterializedNodes() const
+{
+	uint64_t numNodes = 0;
+
+	for (const auto& level : _levels)
+		numNodes += level.size();
+
+	return numNodes;
+}
+
+void Octree::getMaterializedNodesInLevel(unsigned int level, std::vector<unsigned int>& nodeIDs) const
+{
+	nodeIDs.clear();
+
+	if (level > _deepestLevel)
+		return;
+
+	const unsigned int firstNode = getLevelFirstNodeID(level);
+
+	nodeIDs.reserve(_levels[level].size());
+	for (const auto& node : _levels[level])
+		nodeIDs.push_back(firstNode + node.first);
+
+	std::sort(nodeIDs.begin(), nodeIDs.end());
 }
 
 int Octree::getLevelFirstNodeID(unsigned int level) const
@@ -287,10 +349,7 @@ int Octree::getLevelFirstNodeID(unsigned int level) const
 	if (level > _deepestLevel)
 		return -1;
 
-	if (level == 0)
-		return 0;
-
-	return _levelSizesInclusiveSum[level - 1];
+	return NodeAddressing::getLevelFirstNodeID(level);
 }
 
 int Octree::getNumNodesInLevel(unsigned int level) const
@@ -298,20 +357,23 @@ int Octree::getNumNodesInLevel(unsigned int level) const
 	if (level > _deepestLevel)
 		return -1;
 
-	return ipow(OCTREE_NUM_CHILDREN, level);
+	return NodeAddressing::getNumNodesInLevel(level);
 }
 
 uint64_t Octree::getOctreeSizeBytes() const
 {
 	uint64_t sz = 0;
 
-	sz += _nodes.size() * sizeof(AABB);
+	sz += getNumMaterializedNodes() * sizeof(AABB);
 
 	uint64_t numIndices = 0;
-	for(const auto& node : _nodes)
+	for(const auto& level : _levels)
 	{
-		numIndices += node.edgesAlwaysCast.size();
-		numIndices += node.edgesMayCast.size();
+		for (const auto& node : level)
+		{
+			numIndices += node.second.edgesAlwaysCast.size();
+			numIndices += node.second.edgesMayCast.size();
+		}
 	}
 
 	sz += sizeof(int) * numIndices;
@@ -321,5 +383,6 @@ uint64_t Octree::getOctreeSizeBytes() const
 
 void Octree::makeNodesFit()
 {
-	_nodes.shrink_to_fit();
+	for (auto& level : _levels)
+		level.rehash(0);
 }
\ No newline at end of file
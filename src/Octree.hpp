@@ -2,12 +2,12 @@
 
 #include "AABB.hpp"
 #include "Edge.hpp"
+#include "OctreeAddressing.hpp"
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
 
-#define OCTREE_NUM_CHILDREN 8
-
-int ipow(int base, int exp);
+typedef OctreeAddressing<OCTREE_MAX_DEPTH> NodeAddressing;
 
 struct Node
 {
@@ -49,6 +49,11 @@ public:
 	Octree(unsigned int maxRecursionDepth, const AABB& volume);
 
 	AABB getNodeVolume(unsigned int index) const;
+	AABB calculateNodeVolume(unsigned int nodeID) const;
+	static AABB getChildVolume(const AABB& parentSpace, unsigned int indexWithinParent);
+	static AABB getChildVolume(const AABB& parentSpace, unsigned int indexWithinParent, const glm::vec3& splitPoint);
+	glm::vec3 getNodeSplitPoint(unsigned int nodeID) const;
+	static glm::vec3 getSplitPointFromChild(const AABB& childVolume, unsigned int indexWithinParent);
 
 	int getNodeParent(unsigned int nodeID) const;
 	int getNodeRecursionLevel(unsigned int nodeID) const;
@@ -69,13 +74,15 @@ public:
 
 	Node* getNode(unsigned int nodeID);
 	const Node* getNode(unsigned int nodeID) const;
+	Node* materializeNode(unsigned int nodeID);
 
 	bool nodeExists(unsigned int nodeID) const;
 	bool childrenExist(unsigned int nodeID) const;
 
-	unsigned int getNumNodesInPreviousLevels(int level) const;
 	unsigned int getDeepestLevel() const;
 	unsigned int getTotalNumNodes() const;
+	uint64_t getNumMaterializedNodes() const;
+	void getMaterializedNodesInLevel(unsigned int level, std::vector<unsigned int>& nodeIDs) const;
 	int getLevelFirstNodeID(unsigned int level) const;
 	int getNumNodesInLevel(unsigned int level) const;
 
@@ -86,14 +93,15 @@ public:
 private:
 	unsigned int _deepestLevel;
 
-	void _generateLevelSizes();
 	void _init(const AABB& volume);
 
 	void _createChild(const AABB& parentSpace, unsigned int childID, unsigned int indexWithinParent);
 	int _getCorrespondingChildIndexFromPoint(unsigned int nodeID, const glm::vec3& point) const;
 	bool _isPointInsideOctree(const glm::vec3& point) const;
 
-	std::vector<Node> _nodes;
+	AABB _volume;
 
-	std::vector<unsigned int> _levelSizesInclusiveSum;
+	//Sparse node storage, one map per level keyed by the Morton code of the node within the level
+	//Only nodes holding edges (and their ancestors) are materialized
+	std::vector< std::unordered_map<unsigned int, Node> > _levels;
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "BitOperations.h"
+
+#include <cstdint>
+#include <cassert>
+
+#define OCTREE_NUM_CHILDREN 8
+
+//Deepest level whose node IDs still fit into a signed 32-bit int
+#define OCTREE_MAX_DEPTH 10
+
+//Nodes are numbered level by level, node n has children 8n+1 ... 8n+8
+//This makes parent, children and level computable in constant time
+template<unsigned int MaxDepth>
+class OctreeAddressing
+{
+	static_assert(MaxDepth <= OCTREE_MAX_DEPTH, "Node IDs of deeper octrees do not fit into 32 bits");
+
+public:
+	//Number of nodes in all levels above 'level', (8^level - 1) / 7
+	static constexpr unsigned int calcLevelFirstNodeID(unsigned int level)
+	{
+		return ((uint64_t(1) << (3 * level)) - 1) / 7;
+	}
+
+	static unsigned int getLevelFirstNodeID(unsigned int level)
+	{
+		assert(level <= (MaxDepth + 1));
+
+		return _levelTable.firstNodeID[level];
+	}
+
+	static unsigned int getNumNodesInLevel(unsigned int level)
+	{
+		return 1u << (3 * level);
+	}
+
+	//First node of level L is (8^L - 1) / 7, so 7 * nodeID + 1 lies within [8^L, 8^(L+1))
+	static unsigned int getNodeLevel(unsigned int nodeID)
+	{
+		return GetHighestSetBit(7 * uint64_t(nodeID) + 1) / 3;
+	}
+
+	static unsigned int getNodeParent(unsigned int nodeID)
+	{
+		assert(nodeID > 0);
+
+		return (nodeID - 1) / OCTREE_NUM_CHILDREN;
+	}
+
+	static unsigned int getChildrenStartingID(unsigned int nodeID)
+	{
+		return OCTREE_NUM_CHILDREN * nodeID + 1;
+	}
+
+	static unsigned int getNodeIndexWithinParent(unsigned int nodeID)
+	{
+		assert(nodeID > 0);
+
+		return (nodeID - 1) % OCTREE_NUM_CHILDREN;
+	}
+
+private:
+	struct LevelTable
+	{
+		constexpr LevelTable() : firstNodeID()
+		{
+			for (unsigned int i = 0; i <= (MaxDepth + 1); ++i)
+				firstNodeID[i] = calcLevelFirstNodeID(i);
+		}
+
+		unsigned int firstNodeID[MaxDepth + 2];
+	};
+
+	static constexpr LevelTable _levelTable = LevelTable();
+};
+
+template<unsigned int MaxDepth>
+constexpr typename OctreeAddressing<MaxDepth>::LevelTable OctreeAddressing<MaxDepth>::_levelTable;
@@ -0,0 +1,207 @@
+#include "OctreeNodeStore.hpp"
+
+#include <cstdio>
+#include <cassert>
+
+OctreeNodeStore::OctreeNodeStore(const std::string& pathPrefix, unsigned int deepestLevel, const AABB& volume) : _addressing(deepestLevel, volume)
+{
+	_numNodes = 0;
+	_isValid = true;
+	_readLevel = 0;
+
+	_levels.resize(deepestLevel + 1);
+	_levelStats.resize(deepestLevel + 1);
+
+	for (unsigned int i = 0; i <= deepestLevel; ++i)
+	{
+		LevelFile& level = _levels[i];
+
+		level.path = pathPrefix + ".level" + std::to_string(i);
+		level.writer.open(level.path, std::ios::binary | std::ios::trunc);
+		level.numBytes = 0;
+		level.lastNodeID = -1;
+		level.readOffset = 0;
+		level.childScanOffset = 0;
+
+		_isValid &= level.writer.is_open();
+
+		_levelStats[i].level = i;
+	}
+}
+
+OctreeNodeStore::~OctreeNodeStore()
+{
+	for (auto& level : _levels)
+	{
+		level.writer.close();
+		level.reader.close();
+		level.childScanner.close();
+
+		std::remove(level.path.c_str());
+	}
+}
+
+bool OctreeNodeStore::isValid() const
+{
+	return _isValid;
+}
+
+void OctreeNodeStore::addNode(unsigned int nodeID, const std::vector<unsigned int>& edgesMayCast, const std::vector<int>& edgesAlwaysCast)
+{
+	const unsigned int levelNum = _addressing.getNodeRecursionLevel(nodeID);
+	LevelFile& level = _levels[levelNum];
+
+	assert(int64_t(nodeID) > level.lastNodeID);
+
+	const uint32_t header[OCTREE_NODE_STORE_RECORD_HEADER_SIZE] = { nodeID, uint32_t(edgesMayCast.size()), uint32_t(edgesAlwaysCast.size()) };
+
+	level.writer.write(reinterpret_cast<const char*>(header), sizeof(header));
+	level.writer.write(reinterpret_cast<const char*>(edgesMayCast.data()), std::streamsize(edgesMayCast.size() * sizeof(unsigned int)));
+	level.writer.write(reinterpret_cast<const char*>(edgesAlwaysCast.data()), std::streamsize(edgesAlwaysCast.size() * sizeof(int)));
+
+	_isValid &= level.writer.good();
+
+	const uint64_t numListBytes = sizeof(unsigned int) * edgesMayCast.size() + sizeof(int) * edgesAlwaysCast.size();
+	level.numBytes += sizeof(header) + numListBytes;
+	level.lastNodeID = nodeID;
+
+	//Same accounting as the in-memory octree
+	BuildReport::LevelStats& stats = _levelStats[levelNum];
+	++stats.numNodes;
+	stats.numBytes += sizeof(AABB) + numListBytes;
+	stats.numPotentialEdges += edgesMayCast.size();
+	stats.numSilhouetteEdges += edgesAlwaysCast.size();
+	BuildReport::addToHistogram(stats.potentialHistogram, edgesMayCast.size());
+	BuildReport::addToHistogram(stats.silhouetteHistogram, edgesAlwaysCast.size());
+
+	++_numNodes;
+}
+
+bool OctreeNodeStore::finishWriting()
+{
+	for (auto& level : _levels)
+	{
+		level.writer.close();
+		_isValid &= !level.writer.fail();
+
+		level.reader.open(level.path, std::ios::binary);
+		level.childScanner.open(level.path, std::ios::binary);
+		_isValid &= level.reader.is_open() && level.childScanner.is_open();
+
+		_readChildHeader(level);
+	}
+
+	return _isValid;
+}
+
+uint64_t OctreeNodeStore::getSpilledBytes() const
+{
+	uint64_t numBytes = 0;
+	for (const auto& level : _levels)
+		numBytes += level.numBytes;
+
+	return numBytes;
+}
+
+const BuildReport::LevelStats& OctreeNodeStore::getLevelStats(unsigned int level) const
+{
+	return _levelStats[level];
+}
+
+AABB OctreeNodeStore::getRootVolume() const
+{
+	return _addressing.getNodeVolume(0);
+}
+
+unsigned int OctreeNodeStore::getDeepestLevel() const
+{
+	return _addressing.getDeepestLevel();
+}
+
+uint64_t OctreeNodeStore::getNumNodes() const
+{
+	return _numNodes;
+}
+
+void OctreeNodeStore::_readChildHeader(LevelFile& level)
+{
+	if (level.childScanOffset < level.numBytes)
+		level.childScanner.read(reinterpret_cast<char*>(level.childHeader), sizeof(level.childHeader));
+}
+
+bool OctreeNodeStore::getNextNode(SourceNode& sourceNode)
+{
+	assert(_isValid);
+
+	//Concatenating the levels gives breadth-first order, as node IDs are assigned level by level
+	while (_readLevel < _levels.size() && _levels[_readLevel].readOffset >= _levels[_readLevel].numBytes)
+		++_readLevel;
+
+	if (_readLevel >= _levels.size())
+		return false;
+
+	LevelFile& level = _levels[_readLevel];
+
+	uint32_t header[OCTREE_NODE_STORE_RECORD_HEADER_SIZE];
+	level.reader.read(reinterpret_cast<char*>(header), sizeof(header));
+
+	const unsigned int nodeID = header[0];
+	_readNode.edgesMayCast.resize(header[1]);
+	_readNode.edgesAlwaysCast.resize(header[2]);
+
+	level.reader.read(reinterpret_cast<char*>(_readNode.edgesMayCast.data()), std::streamsize(header[1] * sizeof(unsigned int)));
+	level.reader.read(reinterpret_cast<char*>(_readNode.edgesAlwaysCast.data()), std::streamsize(header[2] * sizeof(int)));
+	level.readOffset += sizeof(header) + sizeof(unsigned int) * uint64_t(header[1]) + sizeof(int) * uint64_t(header[2]);
+
+	if (!level.reader)
+	{
+		_isValid = false;
+		return false;
+	}
+
+	_readNode.volume = _addressing.calculateNodeVolume(nodeID);
+
+	sourceNode.nodeID = nodeID;
+	sourceNode.level = _readLevel;
+	sourceNode.node = &_readNode;
+	sourceNode.childMask = 0;
+
+	//Children follow in the next level in the same order as their parents
+	const int startingChild = _addressing.getChildrenStartingId(nodeID);
+	int firstChildIndex = -1;
+
+	if (startingChild >= 0)
+	{
+		LevelFile& childLevel = _levels[_readLevel + 1];
+
+		while (childLevel.childScanOffset < childLevel.numBytes)
+		{
+			const uint32_t* childHeader = childLevel.childHeader;
+
+			assert(childHeader[0] >= unsigned(startingChild));
+
+			if (childHeader[0] >= unsigned(startingChild) + OCTREE_NUM_CHILDREN)
+				break;
+
+			const unsigned int childIndex = childHeader[0] - startingChild;
+			sourceNode.childMask |= 1 << childIndex;
+
+			if (firstChildIndex < 0)
+				firstChildIndex = childIndex;
+
+			const uint64_t numListBytes = sizeof(unsigned int) * uint64_t(childHeader[1]) + sizeof(int) * uint64_t(childHeader[2]);
+			childLevel.childScanner.seekg(std::streamoff(numListBytes), std::ios::cur);
+			childLevel.childScanOffset += sizeof(childLevel.childHeader) + numListBytes;
+
+			_readChildHeader(childLevel);
+		}
+	}
+
+	//Same split point as the in-memory octree reports
+	if (firstChildIndex >= 0)
+		sourceNode.splitPoint = Octree::getSplitPointFromChild(_addressing.calculateNodeVolume(startingChild + firstChildIndex), firstChildIndex);
+	else
+		sourceNode.splitPoint = _readNode.volume.getCenterPoint();
+
+	return true;
+}
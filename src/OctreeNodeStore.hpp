@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Octree.hpp"
+#include "FrozenOctree.hpp"
+#include "BuildReport.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#define OCTREE_NODE_STORE_RECORD_HEADER_SIZE 3
+
+//Finished nodes of a streamed build, spilled to one file per level and read back breadth-first
+//Nodes of a level have to be added in increasing ID order, which any depth-first build does
+//File record: node ID, number of potential and silhouette edges, followed by both lists
+class OctreeNodeStore : public FrozenOctreeNodeSource
+{
+public:
+	//Files are named pathPrefix.levelN and removed when the store is destroyed
+	OctreeNodeStore(const std::string& pathPrefix, unsigned int deepestLevel, const AABB& volume);
+	~OctreeNodeStore();
+
+	OctreeNodeStore(const OctreeNodeStore&) = delete;
+	OctreeNodeStore& operator=(const OctreeNodeStore&) = delete;
+
+	//False if some file could not be created, written or read back
+	bool isValid() const;
+
+	void addNode(unsigned int nodeID, const std::vector<unsigned int>& edgesMayCast, const std::vector<int>& edgesAlwaysCast);
+
+	//Closes the files and opens them for reading, nodes are read sequentially so only one is in memory at a time
+	bool finishWriting();
+
+	uint64_t getSpilledBytes() const;
+	//Counts and list lengths of the stored nodes, numStoredNodes is left empty
+	const BuildReport::LevelStats& getLevelStats(unsigned int level) const;
+
+	AABB getRootVolume() const override;
+	unsigned int getDeepestLevel() const override;
+	uint64_t getNumNodes() const override;
+	bool getNextNode(SourceNode& sourceNode) override;
+
+private:
+	struct LevelFile
+	{
+		std::string		path;
+		std::ofstream	writer;
+
+		uint64_t		numBytes;
+		int64_t			lastNodeID;
+
+		//Nodes of the level and the same nodes scanned as children of the level above, each with its own position
+		std::ifstream	reader;
+		std::ifstream	childScanner;
+		uint64_t		readOffset;
+		uint64_t		childScanOffset;
+
+		//Header of the next node to scan as a child, valid while childScanOffset is below numBytes
+		uint32_t		childHeader[OCTREE_NODE_STORE_RECORD_HEADER_SIZE];
+	};
+
+	void _readChildHeader(LevelFile& level);
+
+	//Only used for addressing, holds no nodes but the root
+	Octree							_addressing;
+
+	std::vector<LevelFile>			_levels;
+	std::vector<BuildReport::LevelStats> _levelStats;
+	uint64_t						_numNodes;
+	bool							_isValid;
+
+	unsigned int					_readLevel;
+	Node							_readNode;
+};
@@ -0,0 +1,93 @@
+#include "OctreeQueryCache.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+OctreeQueryCache::OctreeQueryCache()
+{
+	clear();
+}
+
+void OctreeQueryCache::clear()
+{
+	_path.clear();
+	_potentialOffsets.clear();
+	_silhouetteOffsets.clear();
+	_potential.clear();
+	_silhouette.clear();
+	_removedPotential.clear();
+	_removedSilhouette.clear();
+
+	_numUnchangedPotential = 0;
+	_numUnchangedSilhouette = 0;
+}
+
+int OctreeQueryCache::update(const FrozenOctree& octree, const glm::vec3& point)
+{
+	octree.getNodePathFromPoint(point, _newPath);
+
+	size_t numSharedLevels = 0;
+	while (numSharedLevels < _path.size() && numSharedLevels < _newPath.size() && _path[numSharedLevels] == _newPath[numSharedLevels])
+		++numSharedLevels;
+
+	const size_t numUnchangedPotential = numSharedLevels < _path.size() ? _potentialOffsets[numSharedLevels] : _potential.size();
+	const size_t numUnchangedSilhouette = numSharedLevels < _path.size() ? _silhouetteOffsets[numSharedLevels] : _silhouette.size();
+
+	_removedPotential.assign(_potential.begin() + numUnchangedPotential, _potential.end());
+	_removedSilhouette.assign(_silhouette.begin() + numUnchangedSilhouette, _silhouette.end());
+
+	_potential.resize(numUnchangedPotential);
+	_silhouette.resize(numUnchangedSilhouette);
+	_potentialOffsets.resize(numSharedLevels);
+	_silhouetteOffsets.resize(numSharedLevels);
+
+	for (size_t level = numSharedLevels; level < _newPath.size(); ++level)
+	{
+		_potentialOffsets.push_back(_potential.size());
+		_silhouetteOffsets.push_back(_silhouette.size());
+
+		octree.getNodeEdges(_newPath[level], _potential, _silhouette);
+	}
+
+	_path.swap(_newPath);
+
+	_numUnchangedPotential = numUnchangedPotential;
+	_numUnchangedSilhouette = numUnchangedSilhouette;
+
+	return _path.empty() ? -1 : int(_path.back());
+}
+
+const std::vector<int>& OctreeQueryCache::getPotentialEdges() const
+{
+	return _potential;
+}
+
+const std::vector<int>& OctreeQueryCache::getSilhouetteEdges() const
+{
+	return _silhouette;
+}
+
+void OctreeQueryCache::getLastChanges(std::vector<int>& addedPotential, std::vector<int>& removedPotential, std::vector<int>& addedSilhouette, std::vector<int>& removedSilhouette) const
+{
+	addedPotential.assign(_potential.begin() + _numUnchangedPotential, _potential.end());
+	removedPotential = _removedPotential;
+	_getSetDifference(addedPotential, removedPotential);
+
+	addedSilhouette.assign(_silhouette.begin() + _numUnchangedSilhouette, _silhouette.end());
+	removedSilhouette = _removedSilhouette;
+	_getSetDifference(addedSilhouette, removedSilhouette);
+}
+
+void OctreeQueryCache::_getSetDifference(std::vector<int>& added, std::vector<int>& removed) const
+{
+	//An edge can leave one level and come back in another, such entries cancel out
+	std::sort(added.begin(), added.end());
+	std::sort(removed.begin(), removed.end());
+
+	std::vector<int> onlyAdded, onlyRemoved;
+	std::set_difference(added.begin(), added.end(), removed.begin(), removed.end(), std::back_inserter(onlyAdded));
+	std::set_difference(removed.begin(), removed.end(), added.begin(), added.end(), std::back_inserter(onlyRemoved));
+
+	added.swap(onlyAdded);
+	removed.swap(onlyRemoved);
+}
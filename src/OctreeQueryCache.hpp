@@ -0,0 +1,44 @@
+#pragma once
+
+#include "FrozenOctree.hpp"
+
+#include <vector>
+
+//Remembers the root-to-leaf path of the last query together with its concatenated edge lists
+//When the light moves to another leaf, only the levels below the last shared ancestor are fetched again
+class OctreeQueryCache
+{
+public:
+	OctreeQueryCache();
+
+	void clear();
+
+	//Returns the leaf containing the point, or -1 if the point lies outside of the octree
+	int update(const FrozenOctree& octree, const glm::vec3& point);
+
+	const std::vector<int>& getPotentialEdges() const;
+	const std::vector<int>& getSilhouetteEdges() const;
+
+	//Set difference between the results of the last two updates, a sign flip shows up as removed and added silhouette edge
+	void getLastChanges(std::vector<int>& addedPotential, std::vector<int>& removedPotential, std::vector<int>& addedSilhouette, std::vector<int>& removedSilhouette) const;
+
+private:
+	void _getSetDifference(std::vector<int>& added, std::vector<int>& removed) const;
+
+	std::vector<unsigned int> _path;
+	std::vector<unsigned int> _newPath;
+
+	//Start of each path level's entries within the concatenated lists
+	std::vector<size_t> _potentialOffsets;
+	std::vector<size_t> _silhouetteOffsets;
+
+	std::vector<int> _potential;
+	std::vector<int> _silhouette;
+
+	//Entries before these were not touched by the last update
+	size_t _numUnchangedPotential;
+	size_t _numUnchangedSilhouette;
+
+	std::vector<int> _removedPotential;
+	std::vector<int> _removedSilhouette;
+};
@@ -1,84 +1,391 @@
 #include "OctreeSilhouettes.hpp"
 #include "Application.hpp"
 
-void OctreeSilhouettes::initialize(const EDGE_CONTAINER_TYPE& edges, const AABB& lightSpace, void* customParams)
+#include <algorithm>
+
+void OctreeSilhouettes::initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams)
 {
 	const auto params = reinterpret_cast<OctreeParams*>(customParams);
 
+	clear();
+	_cacheKey = _getCacheKey(edges, lightSpace, params);
+
 	_octree = std::make_shared<Octree>(params->maxDepthLevel, lightSpace);
 	_visitor = std::make_shared<OctreeVisitor>(_octree);
+	_visitor->setCancelFlag(params->cancelFlag);
+
+	//The octree stays empty with a streamed build, the store holds its nodes until they are frozen
+	std::unique_ptr<OctreeNodeStore> nodeStore;
+
+	if (params->streamingBuild && !params->adaptiveSubdivision && !params->allowIncrementalUpdates)
+	{
+		nodeStore.reset(new OctreeNodeStore(params->streamingParams.spillPathPrefix, params->maxDepthLevel, lightSpace));
+
+		if (nodeStore->isValid())
+			_visitor->addEdgesStreaming(edges, params->streamingParams, *nodeStore);
+
+		if (!nodeStore->finishWriting())
+		{
+			std::cerr << "Octree spill files " << params->streamingParams.spillPathPrefix << ".level* could not be written, building in memory\n";
+			nodeStore.reset();
+		}
+	}
+
+	if (!nodeStore && !_visitor->isBuildCancelled())
+	{
+		if (params->adaptiveSubdivision)
+			_visitor->addEdgesAdaptive(edges, params->adaptiveParams);
+		else
+			_visitor->addEdgesTopDown(edges);
+	}
+
+	if (_visitor->isBuildCancelled())
+	{
+		std::cout << "Octree build cancelled\n";
+		clear();
+		return;
+	}
+
+	_buildReport = _visitor->getBuildReport();
+	_buildReport.setMethod("octree");
+	_buildReport.addParameter("numEdges", double(edges.size()));
+	_buildReport.addParameter("maxDepthLevel", params->maxDepthLevel);
+	_buildReport.addParameter("compressEdgeLists", params->compressEdgeLists);
+	_buildReport.addParameter("adaptiveSubdivision", params->adaptiveSubdivision);
+
+	if (params->adaptiveSubdivision)
+	{
+		_buildReport.addParameter("maxPotentialEdgesPerNode", params->adaptiveParams.maxPotentialEdgesPerNode);
+		_buildReport.addParameter("splitCostPerStoredEdge", params->adaptiveParams.splitCostPerStoredEdge);
+		_buildReport.addParameter("splitPlacement", double(params->adaptiveParams.splitPlacement));
+	}
+
+	if (nodeStore)
+	{
+		_buildReport.addParameter("memoryBudgetBytes", double(params->streamingParams.memoryBudgetBytes));
+		_buildReport.addParameter("spilledBytes", double(nodeStore->getSpilledBytes()));
+	}
+
+	//The build structure is not needed for queries, only the packed lists are kept
+	{
+		BuildReport::PhaseTimer freezePhase(_buildReport, "freeze");
+
+		if (nodeStore)
+			_frozenOctree.freeze(*nodeStore, params->compressEdgeLists);
+		else
+			_frozenOctree.freeze(*_octree, params->compressEdgeLists);
+	}
+
+	if (nodeStore && !nodeStore->isValid())
+	{
+		std::cerr << "Octree spill files " << params->streamingParams.spillPathPrefix << ".level* could not be read back\n";
+		_frozenOctree.clear();
+	}
+
+	if (nodeStore)
+		_addStoredLevelsToBuildReport(*nodeStore);
+	else
+		_addLevelsToBuildReport();
+
+	_buildReport.setStructureSizeBytes(getAccelerationStructureSizeBytes());
+
+	if (params->allowIncrementalUpdates)
+	{
+		_edges = edges;
+		_lightSpace = lightSpace;
+		_params = *params;
+		return;
+	}
+
+	_visitor.reset();
+	_octree.reset();
+}
+
+bool OctreeSilhouettes::canUpdateEdges() const
+{
+	return _visitor != nullptr;
+}
+
+bool OctreeSilhouettes::insertEdges(const EdgeStore& edges)
+{
+	if (!canUpdateEdges())
+		return false;
+
+	BuildReport::PhaseTimer updatePhase(_buildReport, "insertEdges");
+
+	std::vector<unsigned int> edgeIDs(edges.size());
+	for (size_t i = 0; i < edges.size(); ++i)
+		edgeIDs[i] = static_cast<unsigned int>(_edges.size() + i);
+
+	for (unsigned int i = 0; i < edges.size(); ++i)
+		_edges.addEdge(edges, i);
+	_visitor->insertEdges(_edges, edgeIDs);
+
+	std::cout << "Inserting " << edges.size() << " edges took " << updatePhase.stop() << " sec\n";
+
+	_freezeUpdatedOctree();
+
+	return true;
+}
+
+bool OctreeSilhouettes::removeEdges(const std::vector<unsigned int>& edgeIDs)
+{
+	if (!canUpdateEdges() || !_areEdgeIDsValid(edgeIDs))
+		return false;
+
+	BuildReport::PhaseTimer updatePhase(_buildReport, "removeEdges");
+
+	_visitor->removeEdges(_edges, edgeIDs);
+
+	for (const auto edgeID : edgeIDs)
+		_edges.clearOppositeVertices(edgeID);
+
+	std::cout << "Removing " << edgeIDs.size() << " edges took " << updatePhase.stop() << " sec\n";
+
+	_freezeUpdatedOctree();
+
+	return true;
+}
+
+bool OctreeSilhouettes::updateEdges(const std::vector<unsigned int>& edgeIDs, const EdgeStore& newEdges)
+{
+	if (!canUpdateEdges() || edgeIDs.size() != newEdges.size() || !_areEdgeIDsValid(edgeIDs))
+		return false;
+
+	BuildReport::PhaseTimer updatePhase(_buildReport, "updateEdges");
+
+	_visitor->removeEdges(_edges, edgeIDs);
+
+	for (size_t i = 0; i < edgeIDs.size(); ++i)
+		_edges.setEdge(edgeIDs[i], newEdges, unsigned(i));
+
+	_visitor->insertEdges(_edges, edgeIDs);
+
+	std::cout << "Updating " << edgeIDs.size() << " edges took " << updatePhase.stop() << " sec\n";
+
+	_freezeUpdatedOctree();
+
+	return true;
+}
+
+bool OctreeSilhouettes::_areEdgeIDsValid(const std::vector<unsigned int>& edgeIDs) const
+{
+	for (const auto edgeID : edgeIDs)
+	{
+		if (edgeID >= _edges.size())
+			return false;
+	}
+
+	//An edge listed twice would be removed twice, or get two new geometries
+	std::vector<unsigned int> sortedIDs(edgeIDs);
+	std::sort(sortedIDs.begin(), sortedIDs.end());
+
+	return std::adjacent_find(sortedIDs.begin(), sortedIDs.end()) == sortedIDs.end();
+}
+
+void OctreeSilhouettes::_freezeUpdatedOctree()
+{
+	{
+		BuildReport::PhaseTimer freezePhase(_buildReport, "freeze");
+		_frozenOctree.freeze(*_octree, _params.compressEdgeLists);
+	}
+
+	_queryCache.clear();
+	_cacheKey = _getCacheKey(_edges, _lightSpace, &_params);
+
+	_buildReport.clearLevels();
+	_addLevelsToBuildReport();
+	_buildReport.setStructureSizeBytes(getAccelerationStructureSizeBytes());
+}
+
+StructureCacheKey OctreeSilhouettes::_getCacheKey(const EdgeStore& edges, const AABB& lightSpace, const OctreeParams* params)
+{
+	CacheHasher paramsHasher;
+	paramsHasher.addValue(uint32_t(params->maxDepthLevel));
+	paramsHasher.addValue(uint32_t(params->compressEdgeLists));
+	paramsHasher.addValue(uint32_t(params->adaptiveSubdivision));
+
+	if (params->adaptiveSubdivision)
+	{
+		paramsHasher.addValue(uint32_t(params->adaptiveParams.maxPotentialEdgesPerNode));
+		paramsHasher.addValue(params->adaptiveParams.splitCostPerStoredEdge);
+		paramsHasher.addValue(uint32_t(params->adaptiveParams.splitPlacement));
+	}
 
-	_loadOctreeBottomTop(edges);
+	StructureCacheKey key;
+	key.methodType = uint32_t(SilhouetteMethodType::OCTREE);
+	key.edgesHash = CacheHasher::hashEdges(edges);
+	key.lightSpaceHash = CacheHasher::hashAabb(lightSpace);
+	key.paramsHash = paramsHasher.getHash();
+
+	return key;
 }
 
-void OctreeSilhouettes::_loadOctreeBottomTop(const EDGE_CONTAINER_TYPE& edges)
+bool OctreeSilhouettes::save(const std::string& path) const
 {
-	_visitor->addEdges(edges);
+	if (!_frozenOctree.isValid())
+		return false;
+
+	StructureCacheWriter writer(_cacheKey);
+	_frozenOctree.save(writer);
+
+	return writer.saveToFile(path);
 }
 
-void OctreeSilhouettes::_loadOctreeTopBottom(const EDGE_CONTAINER_TYPE& edges)
+bool OctreeSilhouettes::load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams)
 {
-	unsigned int i = 0;
-	for (const auto edge : edges)
+	const auto params = reinterpret_cast<OctreeParams*>(customParams);
+
+	clear();
+
+	const StructureCacheKey key = _getCacheKey(edges, lightSpace, params);
+
+	StructureCacheReader reader;
+	if (!reader.open(path, key) || !_frozenOctree.load(reader))
 	{
-		_visitor->addEdge(edge, i);
-		++i;
+		_frozenOctree.clear();
+		return false;
 	}
+
+	_cacheKey = key;
+	_cacheFile = reader.getMappedFile();
+
+	return true;
 }
 
 uint64_t OctreeSilhouettes::getAccelerationStructureSizeBytes() const
 {
-	return _octree->getOctreeSizeBytes();
+	return _frozenOctree.getSizeBytes();
 }
 
 void OctreeSilhouettes::getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices)
 {
-	const int lowestNode = _visitor->getLowestNodeIndexFromPoint(lightPos);
+	if (_queryCache.update(_frozenOctree, lightPos) < 0)
+		return;
 
-	std::cout << "Light containing node: " << lowestNode << std::endl;
+	const auto& potential = _queryCache.getPotentialEdges();
+	const auto& silhouette = _queryCache.getSilhouetteEdges();
 
-	if (lowestNode < 0)
-		return;
+	potentialEdgeIndices.insert(potentialEdgeIndices.end(), potential.begin(), potential.end());
+	silhouetteEdgeIndices.insert(silhouetteEdgeIndices.end(), silhouette.begin(), silhouette.end());
+}
 
-	const auto n = _octree->getNode(lowestNode);
-	auto minP = n->volume.getMinPoint();
-	auto maxP = n->volume.getMaxPoint();
-	std::cout << "Node space " << minP.x << ", " << minP.y << ", " << minP.z << " Max: " << maxP.x << ", " << maxP.y << ", " << maxP.z << "\n";
-	minP = n->volume.getCenterPoint();
-	n->volume.getExtents(maxP.x, maxP.y, maxP.z);
-	std::cout << "Center " << minP.x << ", " << minP.y << ", " << minP.z << " Extents: " << maxP.x << ", " << maxP.y << ", " << maxP.z << "\n";
+void OctreeSilhouettes::visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const
+{
+	_frozenOctree.visitEdgesFromPoint(lightPos, visitor);
+}
 
-	if (lowestNode < 0)
-		return;
+int OctreeSilhouettes::_getLightGroupKey(const glm::vec3& lightPos) const
+{
+	//Storage index is not enough, leaves of shared subtrees are reached through different ancestors
+	return _frozenOctree.getLowestNodeCellIDFromPoint(lightPos);
+}
 
-	_visitor->getSilhouttePotentialEdgesFromNodeUp(potentialEdgeIndices, silhouetteEdgeIndices, lowestNode);
+void OctreeSilhouettes::_getLightGroupsSilhouetteEdges(const std::vector<glm::vec3>& groupLightPositions, std::vector< std::vector<int> >& potential, std::vector< std::vector<int> >& silhouette) const
+{
+	//Groups are ordered by their leaf, so neighbouring groups share most of their ancestors
+	//Each thread walks a contiguous range of groups and only fetches the levels that differ
+	const int numGroups = int(groupLightPositions.size());
+
+	#pragma omp parallel
+	{
+		OctreeQueryCache queryCache;
+
+		#pragma omp for schedule(static)
+		for (int i = 0; i < numGroups; ++i)
+		{
+			queryCache.update(_frozenOctree, groupLightPositions[i]);
+
+			potential[i] = queryCache.getPotentialEdges();
+			silhouette[i] = queryCache.getSilhouetteEdges();
+		}
+	}
+}
+
+void OctreeSilhouettes::_addLevelsToBuildReport()
+{
+	std::vector<unsigned int> nodeIDs;
+
+	for (unsigned int i = 0; i <= _octree->getDeepestLevel(); ++i)
+	{
+		BuildReport::LevelStats level;
+		level.level = i;
+
+		_octree->getMaterializedNodesInLevel(i, nodeIDs);
+		level.numNodes = nodeIDs.size();
+		level.numStoredNodes = _getNumFrozenNodesInLevel(i);
+
+		//Same accounting as Octree::getOctreeSizeBytes, sizes before the lists are packed and shared
+		level.numBytes = level.numNodes * sizeof(AABB);
+
+		for (const auto nodeID : nodeIDs)
+		{
+			const Node* node = _octree->getNode(nodeID);
+
+			level.numPotentialEdges += node->edgesMayCast.size();
+			level.numSilhouetteEdges += node->edgesAlwaysCast.size();
+			level.numBytes += sizeof(int) * (node->edgesMayCast.size() + node->edgesAlwaysCast.size());
+
+			BuildReport::addToHistogram(level.potentialHistogram, node->edgesMayCast.size());
+			BuildReport::addToHistogram(level.silhouetteHistogram, node->edgesAlwaysCast.size());
+		}
+
+		_buildReport.addLevel(level);
+	}
+}
+
+void OctreeSilhouettes::_addStoredLevelsToBuildReport(const OctreeNodeStore& nodeStore)
+{
+	for (unsigned int i = 0; i <= nodeStore.getDeepestLevel(); ++i)
+	{
+		BuildReport::LevelStats level = nodeStore.getLevelStats(i);
+		level.numStoredNodes = _getNumFrozenNodesInLevel(i);
+
+		_buildReport.addLevel(level);
+	}
+}
+
+unsigned int OctreeSilhouettes::_getNumFrozenNodesInLevel(unsigned int level) const
+{
+	unsigned int firstNode;
+	unsigned int numNodes = 0;
+	if (level <= _frozenOctree.getDeepestLevel())
+		_frozenOctree.getLevelNodeRange(level, firstNode, numNodes);
+
+	return numNodes;
+}
+
+const OctreeQueryCache& OctreeSilhouettes::getQueryCache() const
+{
+	return _queryCache;
 }
 
 void OctreeSilhouettes::clear()
 {
-	
+	_visitor.reset();
+	_octree.reset();
+	_frozenOctree.clear();
+	_queryCache.clear();
+	_cacheFile.reset();
+	_buildReport.clear();
+	_edges.clear();
 }
 
 void OctreeSilhouettes::printLevelOccupancies() const
 {
-	for(int i = _octree->getDeepestLevel(); i > 0; --i)
+	for(int i = _frozenOctree.getDeepestLevel(); i >= 0; --i)
 	{
-		const auto firstNode = _octree->getLevelFirstNodeID(i);
-		const auto levelSize = _octree->getNumNodesInLevel(i);
+		unsigned int firstNode, numNodes;
+		_frozenOctree.getLevelNodeRange(i, firstNode, numNodes);
 
 		uint64_t numPotential = 0;
 		uint64_t numSilhouette = 0;
-		for(int n = firstNode; n<(firstNode + levelSize); ++n)
+		for(unsigned int n = firstNode; n<(firstNode + numNodes); ++n)
 		{
-			const auto node = _octree->getNode(n);
-
-			if(n)
-			{
-				numPotential += node->edgesMayCast.size();
-				numSilhouette += node->edgesAlwaysCast.size();
-			}
+			numPotential += _frozenOctree.getNumEdgesMayCast(n);
+			numSilhouette += _frozenOctree.getNumEdgesAlwaysCast(n);
 		}
 
-		std::cout << "Level " << i << ": potential " << numPotential << " silhouette " << numSilhouette << std::endl;
+		std::cout << "Level " << i << ": nodes " << numNodes << " potential " << numPotential << " silhouette " << numSilhouette << std::endl;
 	}
 }
\ No newline at end of file
@@ -3,10 +3,34 @@
 #include "AbstractSilhouetteMethod.hpp"
 #include "OctreeVisitor.hpp"
 #include "Octree.hpp"
+#include "FrozenOctree.hpp"
+#include "OctreeQueryCache.hpp"
+#include "OctreeNodeStore.hpp"
 
 struct OctreeParams
 {
+	OctreeParams() : maxDepthLevel(5), compressEdgeLists(false), adaptiveSubdivision(false), allowIncrementalUpdates(false), streamingBuild(false), cancelFlag(nullptr) {}
+
+	//With adaptive subdivision, this only limits the depth
 	unsigned int maxDepthLevel;
+
+	//Stores node edge lists delta + varint encoded, decoded while querying
+	bool		 compressEdgeLists;
+
+	//Splits only nodes where it pays off instead of the whole tree down to maxDepthLevel
+	bool						adaptiveSubdivision;
+	AdaptiveSubdivisionParams	adaptiveParams;
+
+	//Keeps the build octree and a copy of the edges after initialize, so that edges can be changed without a rebuild
+	bool						allowIncrementalUpdates;
+
+	//Builds subtree by subtree within a memory budget, spilling finished nodes to files, the result is the same
+	//Not available with adaptive subdivision or incremental updates, which need the whole octree
+	bool						streamingBuild;
+	StreamingBuildParams		streamingParams;
+
+	//Set from another thread to stop initialize early, the structure is left empty then
+	const std::atomic<bool>*	cancelFlag;
 };
 
 
@@ -14,20 +38,61 @@ class OctreeSilhouettes : public AbstractSilhouetteMethod
 {
 public:
 	void getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices) override;
+	void visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const override;
 
-	void initialize(const EDGE_CONTAINER_TYPE& edges, const AABB& lightSpace, void* customParams) override;
+	void initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
 
 	void clear() override;
 
 	uint64_t getAccelerationStructureSizeBytes() const override;
 
+	bool save(const std::string& path) const override;
+	bool load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
 	void printLevelOccupancies() const;
 
+	//Only subtrees where the changed edges are potentially silhouette are visited, then the octree is frozen again
+	//Needs OctreeParams::allowIncrementalUpdates, structures loaded from the cache can not be updated
+	bool canUpdateEdges() const;
+	//New edges get IDs following the current ones, IDs of the other edges never change
+	bool insertEdges(const EdgeStore& edges);
+	//IDs of removed edges stay reserved, as edges without neighbouring triangles
+	//Batches with an unknown or repeated ID are rejected
+	bool removeEdges(const std::vector<unsigned int>& edgeIDs);
+	bool updateEdges(const std::vector<unsigned int>& edgeIDs, const EdgeStore& newEdges);
+
+	//Holds the result of the last query, including what changed since the one before
+	const OctreeQueryCache& getQueryCache() const;
+
+protected:
+
+	int _getLightGroupKey(const glm::vec3& lightPos) const override;
+	void _getLightGroupsSilhouetteEdges(const std::vector<glm::vec3>& groupLightPositions, std::vector< std::vector<int> >& potential, std::vector< std::vector<int> >& silhouette) const override;
+
 private:
 
-	void _loadOctreeTopBottom(const EDGE_CONTAINER_TYPE& edges);
-	void _loadOctreeBottomTop(const EDGE_CONTAINER_TYPE& edges);
+	static StructureCacheKey _getCacheKey(const EdgeStore& edges, const AABB& lightSpace, const OctreeParams* params);
+
+
+	//Per-level node counts, memory and list lengths of the built octree and its frozen form
+	void _addLevelsToBuildReport();
+	void _addStoredLevelsToBuildReport(const OctreeNodeStore& nodeStore);
+	unsigned int _getNumFrozenNodesInLevel(unsigned int level) const;
+
+	bool _areEdgeIDsValid(const std::vector<unsigned int>& edgeIDs) const;
+	void _freezeUpdatedOctree();
 
 	std::shared_ptr<Octree>			_octree;
 	std::shared_ptr<OctreeVisitor>	_visitor;
+
+	//Kept only with incremental updates allowed
+	EdgeStore						_edges;
+	AABB							_lightSpace;
+	OctreeParams					_params;
+
+	FrozenOctree					_frozenOctree;
+	OctreeQueryCache				_queryCache;
+
+	StructureCacheKey				_cacheKey;
+	std::shared_ptr<MappedFile>		_cacheFile;
 };
@@ -1,538 +1,1335 @@
 #include "OctreeVisitor.hpp"
 #include "Plane.hpp"
 #include "GeometryOperations.hpp"
+#include "OctreeNodeStore.hpp"
+#include "SyblingEdgeClassifier.hpp"
+#include "LatticeEdgeClassifier.hpp"
 
-#include <stack>
 #include <iostream>
+#include <algorithm>
 
-#include <omp.h>
-#include "HighResolutionTimer.hpp"
+//Result of an edge in a subtree where it is classified differently in different nodes
+#define OCTREE_MIXED_SUBTREE_RESULT -1
+
+//Local edge copy, planes and bookkeeping of an edge in an in-memory subtree of a streamed build
+#define OCTREE_STREAMING_BYTES_PER_EDGE 256
+//List entries kept per crossed node while building, including the lists passed down and the silhouette edges of uniform children
+#define OCTREE_STREAMING_LIST_ENTRIES_PER_CROSSED_NODE 2
+
+//Leaves along an axis of a block the builds classify as one lattice, the grandchildren of a node
+#define OCTREE_LEAF_BLOCK_SIZE 4
+#define OCTREE_LEAF_BLOCK_NUM_CELLS (OCTREE_LEAF_BLOCK_SIZE * OCTREE_LEAF_BLOCK_SIZE * OCTREE_LEAF_BLOCK_SIZE)
+
+//One pass over 8 sorted sibling lists, entries present in all of them are appended to common (sorted)
+//and removed from the siblings, the remainders are compacted in place
+template<typename T>
+static void extractCommonSortedEdges(std::vector<T>* (&syblingLists)[OCTREE_NUM_CHILDREN], std::vector<T>& common)
+{
+	for (const auto list : syblingLists)
+	{
+		if (list->empty())
+			return;
+	}
+
+	size_t readPos[OCTREE_NUM_CHILDREN] = {};
+	size_t writePos[OCTREE_NUM_CHILDREN] = {};
+
+	//An entry missing from the first list cannot be common, so the first list drives the merge
+	std::vector<T>& first = *syblingLists[0];
+	const size_t firstSize = first.size();
+
+	for (; readPos[0] < firstSize; ++readPos[0])
+	{
+		const T value = first[readPos[0]];
+		bool isCommon = true;
+
+		for (unsigned int i = 1; i < OCTREE_NUM_CHILDREN; ++i)
+		{
+			std::vector<T>& list = *syblingLists[i];
+			const size_t size = list.size();
+
+			size_t r = readPos[i];
+			size_t w = writePos[i];
+
+			while (r < size && list[r] < value)
+				list[w++] = list[r++];
+
+			readPos[i] = r;
+			writePos[i] = w;
+
+			if (r == size || list[r] != value)
+			{
+				isCommon = false;
+				break;
+			}
+		}
+
+		if (isCommon)
+		{
+			common.push_back(value);
+
+			for (unsigned int i = 1; i < OCTREE_NUM_CHILDREN; ++i)
+				++readPos[i];
+		}
+		else
+			first[writePos[0]++] = value;
+	}
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		std::vector<T>& list = *syblingLists[i];
+		const size_t size = list.size();
+
+		size_t w = writePos[i];
+		for (size_t r = readPos[i]; r < size; ++r)
+			list[w++] = list[r];
+
+		list.resize(w);
+	}
+}
+
+//Temporary lists of one node, allocated from the current build arena
+struct ArenaEdgeLists
+{
+	BuildArenaVector<unsigned int>	mayCast;
+	BuildArenaVector<int>			alwaysCast;
+
+	//Sorted copies without spare capacity, taken before the arena is reset
+	void copyToNode(Node& node)
+	{
+		std::sort(mayCast.begin(), mayCast.end());
+		std::sort(alwaysCast.begin(), alwaysCast.end());
+
+		node.edgesMayCast.assign(mayCast.begin(), mayCast.end());
+		node.edgesAlwaysCast.assign(alwaysCast.begin(), alwaysCast.end());
+	}
+};
+
+//Leaves below the 8 children of a node, children are split independently along each axis, so the leaves are products of intervals
+struct OctreeLeafBlock
+{
+	LatticeEdgeClassifier	lattice;
+	unsigned int			leafStartingIDs[OCTREE_NUM_CHILDREN];
+	//Lattice cell of leaf j of child i
+	unsigned int			leafCells[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN];
+	EdgeSilhouetness		cellResults[OCTREE_LEAF_BLOCK_NUM_CELLS];
+};
+
+template<typename T>
+static void mergeSortedEdges(std::vector<T>& list, const std::vector<T>& sortedEdges)
+{
+	if (sortedEdges.empty())
+		return;
+
+	const size_t oldSize = list.size();
+	list.insert(list.end(), sortedEdges.begin(), sortedEdges.end());
+	std::inplace_merge(list.begin(), list.begin() + oldSize, list.end());
+}
 
 OctreeVisitor::OctreeVisitor(std::shared_ptr<Octree> octree)
 {
 	_octree = octree;
+	_isAdaptive = false;
+	_cancelFlag = nullptr;
+	_threadPool = BuildThreadPool::getShared();
+	_workerArenas.resize(_threadPool->getNumWorkers() + 1);
+	_workerEdgeTests.resize(_threadPool->getNumWorkers() + 1);
 }
 
-void OctreeVisitor::addEdge(const EDGE_TYPE& edgeInfo, int edgeID)
+void OctreeVisitor::addEdgesAdaptive(const EdgeStore& edges, const AdaptiveSubdivisionParams& params)
 {
-	Plane p1, p2;
+	_isAdaptive = true;
+	_threadPool->resetWorkerStats();
 
-	const auto sz = edgeInfo.second.size();
+	BuildReport::PhaseTimer buildPhase(_buildReport, "adaptiveBuild");
 
-	assert(sz <= 2);
+	BuildNode root;
+	std::vector<unsigned int> openEdges;
+	std::vector<unsigned int> potentialEdges;
+	_classifyEdgesInRoot(edges, root, openEdges, potentialEdges);
 
-	if (sz == 0)
-		return;
-	if(sz==1)
 	{
-		_storeEdgeIsPotentiallySilhouette(0, edgeID);
+		BuildThreadPool::TaskGroup rootTask(*_threadPool);
+		rootTask.run([&]() { _buildAdaptiveSubtree(root, 0, potentialEdges, edges, params); });
+	}
+
+	root.node.edgesMayCast.insert(root.node.edgesMayCast.end(), openEdges.begin(), openEdges.end());
+	root.node.sortEdgeVectors();
+
+	_storeBuildSubtree(root, 0);
+
+	std::cout << "Adaptive build took " << buildPhase.stop() << " sec, " << _octree->getNumMaterializedNodes() << " nodes\n";
+	_collectWorkerEdgeTests();
+	_printThreadPoolStats();
+	_releaseWorkerArenas();
+}
+
+void OctreeVisitor::_buildAdaptiveSubtree(BuildNode& buildNode, unsigned int level, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, const AdaptiveSubdivisionParams& params) const
+{
+	if (level >= _octree->getDeepestLevel() || potentialEdges.size() <= params.maxPotentialEdgesPerNode || isBuildCancelled())
+	{
+		buildNode.node.edgesMayCast.swap(potentialEdges);
+		buildNode.node.sortEdgeVectors();
 		return;
 	}
 
-	GeometryOps::buildEdgeTrianglePlane(edgeInfo.first, edgeInfo.second[0], p1);
-	GeometryOps::buildEdgeTrianglePlane(edgeInfo.first, edgeInfo.second[1], p2);
+	const AABB& volume = buildNode.node.volume;
+	const bool isMidpointSplit = params.splitPlacement == OctreeSplitPlacement::MIDPOINT;
+	const glm::vec3 splitPoint = isMidpointSplit ? volume.getCenterPoint() : _getAdaptiveSplitPoint(volume, potentialEdges, edges, params.splitPlacement);
+
+	Node children[OCTREE_NUM_CHILDREN];
+	float childProbabilities[OCTREE_NUM_CHILDREN];
 
-	std::stack<unsigned int> nodeStack;
-	nodeStack.push(0);
+	float parentX, parentY, parentZ;
+	volume.getExtents(parentX, parentY, parentZ);
+	const float parentVolume = parentX * parentY * parentZ;
 
-	while(!nodeStack.empty())
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		int node = nodeStack.top();
-		nodeStack.pop();
+		children[i].volume = isMidpointSplit ? Octree::getChildVolume(volume, i) : Octree::getChildVolume(volume, i, splitPoint);
 
-		if (!_octree->nodeExists(node))
-			_octree->splitNode(_octree->getNodeParent(node));
+		float x, y, z;
+		children[i].volume.getExtents(x, y, z);
+		childProbabilities[i] = parentVolume > 0 ? (x * y * z) / parentVolume : 1.0f / OCTREE_NUM_CHILDREN;
+	}
 
-		EdgeSilhouetness testResult = GeometryOps::testEdgeSpaceAabb(p1, p2, edgeInfo, _octree->getNodeVolume(node));
+	{
+		//Lists of rejected splits are dropped with the arena
+		BuildArena& arena = _getWorkerArena();
+		arena.reset();
+		BuildArena::Scope arenaScope(arena);
 
-		if (EDGE_IS_SILHOUETTE(testResult))
-			_storeEdgeIsAlwaysSilhouette(testResult, node, edgeID);
-		else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+		ArenaEdgeLists childLists[OCTREE_NUM_CHILDREN];
+		EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
+
+		//Saving is the expected number of potential edges a query inside this node no longer tests,
+		//cost is the number of additional list entries - edges classified the same in all children stay in this node
+		float expectedSaving = 0;
+		int64_t numAdditionalEntries = 0;
+
+		AABB childVolumes[OCTREE_NUM_CHILDREN];
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			childVolumes[i] = children[i].volume;
+
+		SyblingEdgeClassifier classifier;
+		classifier.setVolumes(childVolumes);
+
+		for (const auto edge : potentialEdges)
 		{
-			const int childrenStart = _octree->getChildrenStartingId(node);
+			EdgeSilhouetness firstResult = EdgeSilhouetness::EDGE_NOT_SILHOUETTE;
+			int numEntries = 0;
+			bool isSameInAllChildren = true;
 
-			if (childrenStart >= 0)
+			EdgeSilhouetness testResults[OCTREE_NUM_CHILDREN];
+			classifier.classifyEdge(edges, edge, testResults);
+
+			for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 			{
-				for (int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
-					nodeStack.push(childrenStart + i);
+				const EdgeSilhouetness testResult = testResults[i];
+				edgeTests.add(testResult);
+
+				if (i == 0)
+					firstResult = testResult;
+
+				isSameInAllChildren &= testResult == firstResult;
+
+				if (EDGE_IS_SILHOUETTE(testResult))
+				{
+					childLists[i].alwaysCast.push_back(encodeSilhouetteEdge(edge, testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS ? 1 : -1));
+					expectedSaving += childProbabilities[i];
+					++numEntries;
+				}
+				else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+				{
+					childLists[i].mayCast.push_back(edge);
+					++numEntries;
+				}
+				else
+					expectedSaving += childProbabilities[i];
 			}
-			else
-				_storeEdgeIsPotentiallySilhouette(node, edgeID);
+
+			//Not silhouette anywhere means the edge is dropped, one entry less
+			if (!isSameInAllChildren || numEntries == 0)
+				numAdditionalEntries += numEntries - 1;
 		}
+
+		if (expectedSaving <= 0 || expectedSaving <= params.splitCostPerStoredEdge * numAdditionalEntries)
+		{
+			buildNode.node.edgesMayCast.swap(potentialEdges);
+			buildNode.node.sortEdgeVectors();
+			return;
+		}
+
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			childLists[i].copyToNode(children[i]);
 	}
+
+	std::vector<unsigned int>().swap(potentialEdges);
+
+	BuildThreadPool::TaskGroup childTasks(*_threadPool);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		BuildNode* child = new BuildNode;
+		child->node.volume = children[i].volume;
+		child->node.edgesAlwaysCast.swap(children[i].edgesAlwaysCast);
+		buildNode.children[i].reset(child);
+
+		std::vector<unsigned int>* childPotential = &children[i].edgesMayCast;
+		childTasks.run([this, child, level, childPotential, &edges, &params]() { _buildAdaptiveSubtree(*child, level + 1, *childPotential, edges, params); });
+	}
+
+	childTasks.wait();
+
+	_moveCommonChildEdgesToParent(buildNode);
+	_removeEmptyLeafChildren(buildNode);
+
+	buildNode.node.sortEdgeVectors();
 }
 
-void OctreeVisitor::addEdges(const EDGE_CONTAINER_TYPE& edges)
+void OctreeVisitor::addEdgesTopDown(const EdgeStore& edges)
 {
-	_expandWholeOctree();
+	_threadPool->resetWorkerStats();
 
-	std::vector< std::vector<Plane> > edgePlanes;
-	_generateEdgePlanes(edges, edgePlanes);
-	
-	HighResolutionTimer t;
-	t.reset();
-	_addEdgesOnLowestLevel(edgePlanes, edges);
-	auto dt = t.getElapsedTimeFromLastQueryMilliseconds();
+	BuildReport::PhaseTimer buildPhase(_buildReport, "topDownBuild");
 
-	std::cout << "Adding edges took " << dt / 1000.0f << " sec\n";
-	t.reset();
-	const auto startingLevel = _octree->getDeepestLevel() - 1;
-	_propagatePotentiallySilhouetteEdgesUpFromLevel(startingLevel);
-	dt = t.getElapsedTimeFromLastQueryMilliseconds();
+	BuildNode root;
+	std::vector<unsigned int> openEdges;
+	std::vector<unsigned int> potentialEdges;
+	_classifyEdgesInRoot(edges, root, openEdges, potentialEdges);
 
-	std::cout << "Propagate Potential edges took " << dt / 1000.0f << " sec\n";
-	t.reset();
+	{
+		BuildThreadPool::TaskGroup rootTask(*_threadPool);
+		rootTask.run([&]() { _buildCulledSubtree(root, 0, potentialEdges, edges, true); });
+	}
 
-	_propagateSilhouetteEdgesUpFromLevel(startingLevel);
+	root.node.edgesMayCast.insert(root.node.edgesMayCast.end(), openEdges.begin(), openEdges.end());
+	root.node.sortEdgeVectors();
 
-	dt = t.getElapsedTimeFromLastQueryMilliseconds();
+	_storeBuildSubtree(root, 0);
 
-	std::cout << "Propagate Silhouette edges took " << dt / 1000.0f << " sec\n";
+	std::cout << "Top-down build took " << buildPhase.stop() << " sec, " << _octree->getNumMaterializedNodes() << " nodes\n";
+	_collectWorkerEdgeTests();
+	_printThreadPoolStats();
+	_releaseWorkerArenas();
 }
 
-void OctreeVisitor::_generateEdgePlanes(const EDGE_CONTAINER_TYPE& edges, std::vector< std::vector<Plane> >& planes) const
+void OctreeVisitor::_classifyEdgesInRoot(const EdgeStore& edges, BuildNode& root, std::vector<unsigned int>& openEdges, std::vector<unsigned int>& potentialEdges) const
 {
-	const auto numEdges = edges.size();
+	root.node.volume = _octree->getNodeVolume(0);
 
-	planes.resize(numEdges);
+	EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
 
-	#pragma omp parallel for
-	for(int i = 0; i<edges.size(); ++i)
+	//Edges with one neighbouring triangle stay potential everywhere, they are never passed down
+	const int numEdges = int(edges.size());
+	for (int i = 0; i < numEdges; ++i)
 	{
-		planes[i].reserve(edges[i].second.size());
-
-		for (const auto oppositeVertex : edges[i].second)
+		if (edges.getNumOppositeVertices(i) == 1)
 		{
-			Plane p;
-			GeometryOps::buildEdgeTrianglePlane(edges[i].first, oppositeVertex, p);
-
-			planes[i].push_back(p);
+			openEdges.push_back(i);
+			continue;
 		}
+
+		if (edges.getNumOppositeVertices(i) != 2)
+			continue;
+
+		const EdgeSilhouetness testResult = GeometryOps::testEdgeSpaceAabb(edges, i, root.node.volume);
+		edgeTests.add(testResult);
+
+		if (EDGE_IS_SILHOUETTE(testResult))
+			root.node.edgesAlwaysCast.push_back(encodeSilhouetteEdge(i, testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS ? 1 : -1));
+		else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+			potentialEdges.push_back(i);
 	}
 }
 
-void OctreeVisitor::_addEdgesOnLowestLevel(std::vector< std::vector<Plane> >& edgePlanes, const EDGE_CONTAINER_TYPE& edges)
+void OctreeVisitor::_buildCulledSubtree(BuildNode& buildNode, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren)
 {
-	const int deepestLevel = _octree->getDeepestLevel();
-	const int levelSize = ipow(OCTREE_NUM_CHILDREN, deepestLevel);
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
 
-	const int startingIndex = _octree->getNumNodesInPreviousLevels(deepestLevel);
-	const int stopIndex = _octree->getTotalNumNodes();
-	
-	std::cout << "Total iterations: " << (stopIndex - startingIndex) / OCTREE_NUM_CHILDREN << "\n";
-
-	#pragma omp parallel for
-	for (int i = startingIndex; i < stopIndex; i += OCTREE_NUM_CHILDREN)
+	if (startingChild < 0 || potentialEdges.empty() || isBuildCancelled())
 	{
-		_addEdgesSyblingsParent(edgePlanes, edges, i);
-		/*
-		static int a = 0;
-		std::cout << "Iter " << a++ << " Added edges to node " << i << " current tree size " << float(_octree->getOctreeSizeBytes()) / 1024.0 / 1024.0 << "MB" << std::endl;
-		//*/
+		buildNode.node.edgesMayCast.swap(potentialEdges);
+		buildNode.node.sortEdgeVectors();
+		return;
 	}
+
+	//The grandchildren of nodes two levels above the bottom are classified as one lattice
+	if (_octree->getNodeRecursionLevel(startingChild) + 1 == int(_octree->getDeepestLevel()))
+		_buildCulledLeafBlock(buildNode, startingChild, potentialEdges, edges, storeChildren);
+	else
+		_buildCulledChildren(buildNode, startingChild, potentialEdges, edges, storeChildren);
+
+	//Edges uniform in all children end in the highest such node
+	_moveCommonChildEdgesToParent(buildNode);
+	_removeEmptyLeafChildren(buildNode);
+
+	//The children are final now, only the paths being built wait in build nodes
+	if (storeChildren)
+		_storeFinishedChildren(buildNode, startingChild);
+
+	buildNode.node.sortEdgeVectors();
 }
 
-void OctreeVisitor::_addEdgesSyblingsParent(const std::vector< std::vector<Plane> >& edgePlanes, const EDGE_CONTAINER_TYPE& edges, unsigned int startingID)
+void OctreeVisitor::_buildCulledChildren(BuildNode& buildNode, unsigned int startingChild, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren)
 {
+	//Only edges potentially silhouette in this node can be anything but uniform in its children,
+	//silhouette and non-silhouette results of a node hold for its whole subtree
+	Node children[OCTREE_NUM_CHILDREN];
+	AABB childVolumes[OCTREE_NUM_CHILDREN];
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		childVolumes[i] = _octree->calculateNodeVolume(startingChild + i);
+		children[i].volume = childVolumes[i];
+	}
+
+	{
+		//Nothing else runs on this thread until the lists are copied, so the arena can be reused by nested tasks afterwards
+		BuildArena& arena = _getWorkerArena();
+		arena.reset();
+		BuildArena::Scope arenaScope(arena);
+
+		ArenaEdgeLists childLists[OCTREE_NUM_CHILDREN];
+		EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
+
+		SyblingEdgeClassifier classifier;
+		classifier.setVolumes(childVolumes);
+
+		for (const auto edge : potentialEdges)
+		{
+			EdgeSilhouetness testResults[OCTREE_NUM_CHILDREN];
+			classifier.classifyEdge(edges, edge, testResults);
+
+			for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			{
+				const EdgeSilhouetness testResult = testResults[i];
+				edgeTests.add(testResult);
+
+				if (EDGE_IS_SILHOUETTE(testResult))
+					childLists[i].alwaysCast.push_back(encodeSilhouetteEdge(edge, testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS ? 1 : -1));
+				else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+					childLists[i].mayCast.push_back(edge);
+			}
+		}
+
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			childLists[i].copyToNode(children[i]);
+	}
 
-	unsigned int edgeIndex = 0;
+	std::vector<unsigned int>().swap(potentialEdges);
 
-	const int parent = _octree->getNodeParent(startingID);
+	BuildThreadPool::TaskGroup childTasks(*_threadPool);
 
-	for (const auto edge : edges)
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		unsigned int numPotential = 0;
-		unsigned int numSilhouette = 0;
+		BuildNode* child = new BuildNode;
+		child->node.volume = children[i].volume;
+		child->node.edgesAlwaysCast.swap(children[i].edgesAlwaysCast);
+		buildNode.children[i].reset(child);
+
+		const unsigned int childID = startingChild + i;
+		std::vector<unsigned int>* childPotential = &children[i].edgesMayCast;
+		childTasks.run([this, child, childID, childPotential, &edges, storeChildren]() { _buildCulledSubtree(*child, childID, *childPotential, edges, storeChildren); });
+	}
 
-		int potentialIndices[OCTREE_NUM_CHILDREN];
-		int silhouetteIndices[OCTREE_NUM_CHILDREN];
+	childTasks.wait();
+}
 
-		const auto numOppositeVertices = edge.second.size();
+void OctreeVisitor::_buildCulledLeafBlock(BuildNode& buildNode, unsigned int startingChild, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren)
+{
+	OctreeLeafBlock block;
+	_initLeafBlock(startingChild, block);
+
+	Node children[OCTREE_NUM_CHILDREN];
+	Node leaves[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN];
+
+	{
+		BuildArena& arena = _getWorkerArena();
+		arena.reset();
+		BuildArena::Scope arenaScope(arena);
 
-		if(numOppositeVertices!=2)
+		ArenaEdgeLists leafLists[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN];
+		ArenaEdgeLists childLists[OCTREE_NUM_CHILDREN];
+		EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
+
+		//Leaves hold the same results as culling in the children would give, the volumes are nested
+		for (const auto edge : potentialEdges)
+			_addLeafBlockEdge(edges, edge, block, leafLists, childLists, edgeTests);
+
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 		{
-			if (numOppositeVertices == 1 && parent >= 0)
-				_storeEdgeIsPotentiallySilhouette(parent, edgeIndex);
+			childLists[i].copyToNode(children[i]);
 
-			edgeIndex++;
-			continue;
+			for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
+				leafLists[i][j].copyToNode(leaves[i][j]);
 		}
+	}
 
-		for (unsigned int index = startingID; index<(startingID + OCTREE_NUM_CHILDREN); index++)
+	std::vector<unsigned int>().swap(potentialEdges);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		BuildNode* child = new BuildNode;
+		child->node.volume = _octree->calculateNodeVolume(startingChild + i);
+		child->node.edgesMayCast.swap(children[i].edgesMayCast);
+		child->node.edgesAlwaysCast.swap(children[i].edgesAlwaysCast);
+		buildNode.children[i].reset(child);
+
+		//Edges common to all leaves of the child are in the child already
+		if (storeChildren)
 		{
-			EdgeSilhouetness testResult = GeometryOps::testEdgeSpaceAabb(edgePlanes[edgeIndex][0], edgePlanes[edgeIndex][1], edge, _octree->getNodeVolume(index));
-
-			if (testResult== EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS)
-				silhouetteIndices[numSilhouette++] = index;
-			else if (testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS)
-				silhouetteIndices[numSilhouette++] = -int(index);
-			else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
-				potentialIndices[numPotential++] = index;
+			const bool leafHasChildren[OCTREE_NUM_CHILDREN] = {};
+			child->hasStoredChildren = _materializeChildren(block.leafStartingIDs[i], leaves[i], leafHasChildren);
+			continue;
 		}
 
-		if (parent >= 0)
+		for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
 		{
-			if (numPotential == OCTREE_NUM_CHILDREN)
-			{
-				_storeEdgeIsPotentiallySilhouette(parent, edgeIndex);
-				numPotential = 0;
-			}
-
-			if (numSilhouette == OCTREE_NUM_CHILDREN)
-			{
-				const bool sameFacing = _doAllSilhouetteFaceTheSame(silhouetteIndices);
-
-				if (sameFacing)
-				{
-					//TODO - problem: hrana 0 sa neda ulozit zaporne!!!
-					const int sign = silhouetteIndices[0] < 0 ? -1 : 1;
-					_storeEdgeIsAlwaysSilhouette(parent, sign * int(edgeIndex));
-					numSilhouette = 0;
-				}
-			}
+			if (leaves[i][j].edgesMayCast.empty() && leaves[i][j].edgesAlwaysCast.empty())
+				continue;
+
+			BuildNode* leaf = new BuildNode;
+			leaf->node.volume = _octree->calculateNodeVolume(block.leafStartingIDs[i] + j);
+			leaf->node.edgesMayCast.swap(leaves[i][j].edgesMayCast);
+			leaf->node.edgesAlwaysCast.swap(leaves[i][j].edgesAlwaysCast);
+			child->children[j].reset(leaf);
 		}
+	}
+}
 
-		for(unsigned int i = 0; i<numPotential; ++i)
-			_storeEdgeIsPotentiallySilhouette(potentialIndices[i], edgeIndex);
+void OctreeVisitor::_removeEmptyLeafChildren(BuildNode& buildNode) const
+{
+	for (auto& child : buildNode.children)
+	{
+		if (!child)
+			continue;
 
-		for (unsigned int i = 0; i<numSilhouette; ++i)
-			_storeEdgeIsAlwaysSilhouette(abs(silhouetteIndices[i]), -int(edgeIndex)*(silhouetteIndices[i]<0) + edgeIndex * (silhouetteIndices[i]>=0));
+		bool hasChildren = child->hasStoredChildren;
+		for (const auto& grandChild : child->children)
+			hasChildren |= grandChild != nullptr;
 
-		++edgeIndex;
+		if (!hasChildren && child->node.edgesMayCast.empty() && child->node.edgesAlwaysCast.empty())
+			child.reset();
 	}
-	
-	for(auto i = startingID; i<(startingID+OCTREE_NUM_CHILDREN); ++i)
+}
+
+void OctreeVisitor::_storeFinishedChildren(BuildNode& buildNode, unsigned int startingID)
+{
+	std::lock_guard<std::mutex> lock(_octreeMutex);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		auto node = _octree->getNode(i);
+		auto& child = buildNode.children[i];
+
+		if (!child)
+			continue;
+
+		Node* node = _octree->materializeNode(startingID + i);
+		node->volume = child->node.volume;
+		node->edgesMayCast.swap(child->node.edgesMayCast);
+		node->edgesAlwaysCast.swap(child->node.edgesAlwaysCast);
+		node->shrinkEdgeVectors();
 
-		if (node)
+		child.reset();
+		buildNode.hasStoredChildren = true;
+	}
+}
+
+glm::vec3 OctreeVisitor::_getAdaptiveSplitPoint(const AABB& volume, const std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, OctreeSplitPlacement placement) const
+{
+	assert(placement == OctreeSplitPlacement::EDGE_MEDIAN && !potentialEdges.empty());
+
+	//Edge planes pass through the edge, so splitting where the edges are dense separates the most plane crossings
+	//Clamping keeps children from degenerating when the edges lie outside of the node
+	const glm::vec3 quarterExtents = (volume.getMaxPoint() - volume.getMinPoint()) * 0.25f;
+	const glm::vec3 lowerBound = volume.getMinPoint() + quarterExtents;
+	const glm::vec3 upperBound = volume.getMaxPoint() - quarterExtents;
+
+	std::vector<float> coordinates(potentialEdges.size());
+	glm::vec3 splitPoint;
+
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		for (size_t i = 0; i < potentialEdges.size(); ++i)
 		{
-			node->shrinkEdgeVectors();
-			node->sortEdgeVectors();
+			const unsigned int edge = potentialEdges[i];
+			coordinates[i] = glm::clamp(0.5f * (edges.getLowerPoint(edge)[axis] + edges.getHigherPoint(edge)[axis]), lowerBound[axis], upperBound[axis]);
 		}
+
+		std::nth_element(coordinates.begin(), coordinates.begin() + coordinates.size() / 2, coordinates.end());
+		splitPoint[axis] = coordinates[coordinates.size() / 2];
 	}
-	//*/
+
+	return splitPoint;
 }
 
-bool OctreeVisitor::_doAllSilhouetteFaceTheSame(const int(&indices)[OCTREE_NUM_CHILDREN]) const
+void OctreeVisitor::_moveCommonChildEdgesToParent(BuildNode& buildNode) const
 {
-	const bool isFirst = indices[0]>0;
+	//Edges potential (or same-signed silhouette) in all children are stored once in the parent
+	std::vector<unsigned int>* mayCastLists[OCTREE_NUM_CHILDREN];
+	std::vector<int>* alwaysCastLists[OCTREE_NUM_CHILDREN];
 
-	for(unsigned int i = 1; i<OCTREE_NUM_CHILDREN; ++i)
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		const bool current = indices[i] > 0;
-
-		if (isFirst != current)
-			return false;
+		mayCastLists[i] = &buildNode.children[i]->node.edgesMayCast;
+		alwaysCastLists[i] = &buildNode.children[i]->node.edgesAlwaysCast;
 	}
 
-	return isFirst;
+	extractCommonSortedEdges(mayCastLists, buildNode.node.edgesMayCast);
+	extractCommonSortedEdges(alwaysCastLists, buildNode.node.edgesAlwaysCast);
 }
 
+void OctreeVisitor::_storeBuildSubtree(BuildNode& buildNode, unsigned int nodeID)
+{
+	Node* node = _octree->materializeNode(nodeID);
+
+	node->volume = buildNode.node.volume;
+	node->edgesMayCast.swap(buildNode.node.edgesMayCast);
+	node->edgesAlwaysCast.swap(buildNode.node.edgesAlwaysCast);
+	node->shrinkEdgeVectors();
+
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
 
-void OctreeVisitor::_storeEdgeIsAlwaysSilhouette(EdgeSilhouetness testResult, unsigned int nodeId, unsigned int edgeID)
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		if (buildNode.children[i])
+			_storeBuildSubtree(*buildNode.children[i], startingChild + i);
+	}
+}
+
+void OctreeVisitor::addEdgesStreaming(const EdgeStore& edges, const StreamingBuildParams& params, OctreeNodeStore& store)
 {
-	if (testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS)
-		_storeEdgeIsAlwaysSilhouette(nodeId, edgeID);
-	else if (testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS)
-		_storeEdgeIsAlwaysSilhouette(nodeId, -int(edgeID));
+	_threadPool->resetWorkerStats();
+
+	BuildReport::PhaseTimer buildPhase(_buildReport, "streamingBuild");
+
+	StreamingBuild build = { edges, params, store, 0, 0 };
+
+	//Edges with one neighbouring triangle stay potential everywhere, they are never passed down
+	std::vector<unsigned int> openEdges;
+	std::vector<unsigned int> rootEdges;
+	for (unsigned int i = 0; i < edges.size(); ++i)
+	{
+		if (edges.getNumOppositeVertices(i) == 1)
+			openEdges.push_back(i);
+		else if (edges.getNumOppositeVertices(i) == 2)
+			rootEdges.push_back(i);
+	}
+
+	Node root;
+	std::vector<unsigned int> potentialEdges;
+	_classifyEdgeChunks(build, rootEdges, _octree->getNodeVolume(0), potentialEdges, root.edgesAlwaysCast);
+	std::vector<unsigned int>().swap(rootEdges);
+
+	_buildStreamedSubtree(build, 0, potentialEdges, root);
+
+	mergeSortedEdges(root.edgesMayCast, openEdges);
+	store.addNode(0, root.edgesMayCast, root.edgesAlwaysCast);
+
+	std::cout << "Streaming build took " << buildPhase.stop() << " sec, " << store.getNumNodes() << " nodes, " << build.numInMemorySubtrees << " subtrees built in memory, largest "
+		<< build.largestSubtreeBytes / 1024.0 / 1024.0 << "MB\n";
+	_collectWorkerEdgeTests();
+	_printThreadPoolStats();
+	_releaseWorkerArenas();
 }
 
-void OctreeVisitor::_storeEdgeIsAlwaysSilhouette(unsigned int nodeId, int augmentedEdgeIdWithResult)
+void OctreeVisitor::_classifyEdgeChunks(const StreamingBuild& build, const std::vector<unsigned int>& edgeIDs, const AABB& volume, std::vector<unsigned int>& potentialEdges, std::vector<int>& silhouetteEdges) const
 {
-	auto node = _octree->getNode(nodeId);
+	const size_t chunkSize = std::max(build.params.edgeChunkSize, 1u);
+	std::vector<EdgeSilhouetness> results;
 
-	assert(node != nullptr);
+	for (size_t chunkStart = 0; chunkStart < edgeIDs.size() && !isBuildCancelled(); chunkStart += chunkSize)
+	{
+		const int numChunkEdges = int(std::min(chunkSize, edgeIDs.size() - chunkStart));
+		results.resize(numChunkEdges);
+
+		_threadPool->parallelFor(0, numChunkEdges, 256, [&](int begin, int end)
+		{
+			EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
+
+			for (int i = begin; i < end; ++i)
+			{
+				results[i] = GeometryOps::testEdgeSpaceAabb(build.edges, edgeIDs[chunkStart + i], volume);
+				edgeTests.add(results[i]);
+			}
+		});
 
-	node->edgesAlwaysCast.push_back(augmentedEdgeIdWithResult);
+		for (int i = 0; i < numChunkEdges; ++i)
+		{
+			const unsigned int edgeID = edgeIDs[chunkStart + i];
+
+			if (EDGE_IS_SILHOUETTE(results[i]))
+				silhouetteEdges.push_back(encodeSilhouetteEdge(edgeID, results[i] == EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS ? 1 : -1));
+			else if (results[i] == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+				potentialEdges.push_back(edgeID);
+		}
+	}
 }
 
-void OctreeVisitor::_storeEdgeIsPotentiallySilhouette(unsigned int nodeID, unsigned int edgeID)
+bool OctreeVisitor::_buildStreamedSubtree(StreamingBuild& build, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, Node& node)
 {
-	auto node = _octree->getNode(nodeID);
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
 
-	assert(node != nullptr);
+	if (startingChild < 0 || potentialEdges.empty() || isBuildCancelled())
+	{
+		node.edgesMayCast.swap(potentialEdges);
+		node.sortEdgeVectors();
+		return false;
+	}
+
+	const unsigned int numLevelsBelow = _octree->getDeepestLevel() - _octree->getNodeRecursionLevel(nodeID);
+	if (_estimateSubtreeBytes(potentialEdges.size(), numLevelsBelow) <= build.params.memoryBudgetBytes)
+		return _buildSubtreeInMemory(build, nodeID, potentialEdges, node);
+
+	//Children are classified and built one at a time, only their own lists wait for the siblings
+	Node children[OCTREE_NUM_CHILDREN];
+	bool childHasChildren[OCTREE_NUM_CHILDREN];
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		std::vector<unsigned int> childPotentialEdges;
+		_classifyEdgeChunks(build, potentialEdges, _octree->calculateNodeVolume(startingChild + i), childPotentialEdges, children[i].edgesAlwaysCast);
+
+		childHasChildren[i] = _buildStreamedSubtree(build, startingChild + i, childPotentialEdges, children[i]);
+	}
+
+	std::vector<unsigned int>().swap(potentialEdges);
+
+	//Same as _moveCommonChildEdgesToParent and _removeEmptyLeafChildren, the children are final afterwards
+	std::vector<unsigned int>* mayCastLists[OCTREE_NUM_CHILDREN];
+	std::vector<int>* alwaysCastLists[OCTREE_NUM_CHILDREN];
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		mayCastLists[i] = &children[i].edgesMayCast;
+		alwaysCastLists[i] = &children[i].edgesAlwaysCast;
+	}
+
+	extractCommonSortedEdges(mayCastLists, node.edgesMayCast);
+	extractCommonSortedEdges(alwaysCastLists, node.edgesAlwaysCast);
+
+	bool hasChildren = false;
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		if (!childHasChildren[i] && children[i].edgesMayCast.empty() && children[i].edgesAlwaysCast.empty())
+			continue;
+
+		build.store.addNode(startingChild + i, children[i].edgesMayCast, children[i].edgesAlwaysCast);
+		hasChildren = true;
+	}
+
+	node.sortEdgeVectors();
 
-	node->edgesMayCast.push_back(edgeID);
+	return hasChildren;
 }
 
-void OctreeVisitor::processPotentialEdges()
+bool OctreeVisitor::_buildSubtreeInMemory(StreamingBuild& build, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, Node& node)
 {
-	const unsigned int maxLevel = _octree->getDeepestLevel();
+	assert(std::is_sorted(potentialEdges.begin(), potentialEdges.end()));
 
-	_propagatePotentiallySilhouetteEdgesUpFromLevel(maxLevel);
+	//The subtree gets a local copy of its edges, indexed in the order of their IDs, so sorted lists stay sorted when mapped back
+	std::vector<unsigned int> edgeIDs;
+	edgeIDs.swap(potentialEdges);
+
+	EdgeStore localEdges;
+	localEdges.reserve(edgeIDs.size());
+
+	std::vector<unsigned int> localPotentialEdges(edgeIDs.size());
+
+	for (unsigned int i = 0; i < edgeIDs.size(); ++i)
+	{
+		localEdges.addEdge(build.edges, edgeIDs[i]);
+		localPotentialEdges[i] = i;
+	}
+
+	BuildNode subtreeRoot;
+	subtreeRoot.node.volume = _octree->calculateNodeVolume(nodeID);
+
+	{
+		BuildThreadPool::TaskGroup rootTask(*_threadPool);
+		rootTask.run([&]() { _buildCulledSubtree(subtreeRoot, nodeID, localPotentialEdges, localEdges, false); });
+	}
+
+	uint64_t numBytes = edgeIDs.size() * (sizeof(unsigned int) + EdgeStore::getBytesPerEdge());
+
+	//Edges moved up to the subtree root join the ones the node got from its parent
+	for (const auto edge : subtreeRoot.node.edgesMayCast)
+		node.edgesMayCast.push_back(edgeIDs[edge]);
+
+	for (const auto edge : subtreeRoot.node.edgesAlwaysCast)
+		node.edgesAlwaysCast.push_back(encodeSilhouetteEdge(edgeIDs[decodeSilhouetteEdgeID(edge)], decodeSilhouetteEdgeSign(edge)));
+
+	node.sortEdgeVectors();
+
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
+	bool hasChildren = false;
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		if (!subtreeRoot.children[i])
+			continue;
+
+		_spillBuildSubtree(*subtreeRoot.children[i], startingChild + i, edgeIDs, build.store, numBytes);
+		hasChildren = true;
+	}
+
+	++build.numInMemorySubtrees;
+	build.largestSubtreeBytes = std::max(build.largestSubtreeBytes, numBytes);
+
+	return hasChildren;
 }
 
-void OctreeVisitor::_propagatePotentiallySilhouetteEdgesUpFromLevel(unsigned int startingLevel)
+void OctreeVisitor::_spillBuildSubtree(BuildNode& buildNode, unsigned int nodeID, const std::vector<unsigned int>& edgeIDs, OctreeNodeStore& store, uint64_t& numBytes) const
 {
-	for(int i = startingLevel; i>0; --i)
-		_processPotentialEdgesInLevel(i);
+	Node& node = buildNode.node;
+
+	//Mapping keeps the order, so the lists stay sorted
+	for (auto& edge : node.edgesMayCast)
+		edge = edgeIDs[edge];
+
+	for (auto& edge : node.edgesAlwaysCast)
+		edge = encodeSilhouetteEdge(edgeIDs[decodeSilhouetteEdgeID(edge)], decodeSilhouetteEdgeSign(edge));
+
+	store.addNode(nodeID, node.edgesMayCast, node.edgesAlwaysCast);
+
+	numBytes += sizeof(BuildNode) + sizeof(unsigned int) * node.edgesMayCast.capacity() + sizeof(int) * node.edgesAlwaysCast.capacity();
+
+	//Depth-first, so each level gets its nodes in increasing ID order
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		if (buildNode.children[i])
+			_spillBuildSubtree(*buildNode.children[i], startingChild + i, edgeIDs, store, numBytes);
+	}
 }
 
-void OctreeVisitor::_propagateSilhouetteEdgesUpFromLevel(unsigned int startingLevel)
+uint64_t OctreeVisitor::_estimateSubtreeBytes(size_t numPotentialEdges, unsigned int numLevelsBelow)
 {
-	for (int i = startingLevel; i > 0; --i)
-		_processSilhouetteEdgesInLevel(i);
+	//A plane crosses at most about 3 * 4^k of the 8^k nodes k levels below, each edge has two
+	const uint64_t numListEntriesPerEdge = uint64_t(OCTREE_STREAMING_LIST_ENTRIES_PER_CROSSED_NODE) * 2 * 3 * (uint64_t(1) << (2 * numLevelsBelow));
+
+	return numPotentialEdges * (OCTREE_STREAMING_BYTES_PER_EDGE + sizeof(unsigned int) * numListEntriesPerEdge);
 }
 
-OctreeVisitor::TestResult OctreeVisitor::_haveAllSyblingsEdgeAsPotential(unsigned int startingNodeID, unsigned int edgeID) const
-{	
-	TestResult retval = TestResult::NON_EXISTING;
-	
-	for(unsigned int i=0; i<OCTREE_NUM_CHILDREN; ++i)
-	{
-		const auto node = _octree->getNode(startingNodeID + i);
-		
-		if (!node)
-			continue;
+void OctreeVisitor::insertEdges(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs)
+{
+	EdgeUpdateBatch batch;
+	_prepareEdgeUpdateBatch(edges, edgeIDs, batch);
+
+	//Traversal only reads the octree, nodes are materialized and lists merged after all threads are done
+	std::vector< std::vector<NodeEdgeUpdate> > updates(_threadPool->getNumWorkers() + 1);
+	std::vector<int> rootResults;
 
-		if (std::find(node->edgesMayCast.begin(), node->edgesMayCast.end(), edgeID) == node->edgesMayCast.end())
-			return TestResult::FALSE;
-		
-		retval = TestResult::TRUE;
+	{
+		BuildThreadPool::TaskGroup rootTask(*_threadPool);
+		rootTask.run([&]() { _collectInsertedEdges(edges, batch, 0, _octree->getNodeVolume(0), batch.traversedEdges, rootResults, updates); });
 	}
 
-	return retval;
+	NodeEdgeUpdate rootUpdate;
+	rootUpdate.nodeID = 0;
+	rootUpdate.node.edgesMayCast = batch.openEdgeIDs;
+
+	for (size_t i = 0; i < batch.traversedEdges.size(); ++i)
+		_addEdgeResult(rootUpdate.node, batch.edgeIDs[batch.traversedEdges[i]], rootResults[i]);
+
+	updates.back().push_back(std::move(rootUpdate));
+
+	_applyNodeEdgeUpdates(updates);
+	_collectWorkerEdgeTests();
 }
 
-void OctreeVisitor::_processPotentialEdgesInLevel(unsigned int level)
+void OctreeVisitor::removeEdges(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs)
 {
-	assert(level > 0);
-	const int startingID = _getFirstNodeIdInLevel(level);
-	
-	assert(startingID >= 0);
+	EdgeUpdateBatch batch;
+	_prepareEdgeUpdateBatch(edges, edgeIDs, batch);
 
-	const int stopId = ipow(OCTREE_NUM_CHILDREN, level) + startingID;
+	Node* root = _octree->getNode(0);
 
-	int currentID = startingID;
+	std::vector<unsigned int>& rootMayCast = root->edgesMayCast;
+	rootMayCast.erase(std::set_difference(rootMayCast.begin(), rootMayCast.end(), batch.openEdgeIDs.begin(), batch.openEdgeIDs.end(), rootMayCast.begin()), rootMayCast.end());
+
+	std::vector< std::vector<unsigned int> > touchedNodes(_threadPool->getNumWorkers() + 1);
 
-	#pragma omp parallel for
-	for(currentID = startingID; currentID<stopId; currentID += OCTREE_NUM_CHILDREN)
 	{
-		std::set<unsigned int> potentialEdgesSyblings;
-		_getAllPotentialEdgesSyblings(currentID, potentialEdgesSyblings);
+		BuildThreadPool::TaskGroup rootTask(*_threadPool);
+		rootTask.run([&]() { _removeEdgesFromSubtree(edges, batch, 0, *root, batch.traversedEdges, touchedNodes); });
+	}
 
-		for(auto edge : potentialEdgesSyblings)
-		{
-			auto result = _haveAllSyblingsEdgeAsPotential(currentID, edge);
+	std::vector<unsigned int> nodeIDs;
+	for (const auto& workerNodes : touchedNodes)
+		nodeIDs.insert(nodeIDs.end(), workerNodes.begin(), workerNodes.end());
 
-			if (result == TestResult::TRUE)
-			{
-				_assignPotentialEdgeToNodeParent(currentID, edge);
-				_removePotentialEdgeFromSyblings(currentID, edge);
-			}
-		}
+	std::sort(nodeIDs.begin(), nodeIDs.end());
+	_removeEmptyLeaves(nodeIDs);
+
+	_collectWorkerEdgeTests();
+}
+
+void OctreeVisitor::_prepareEdgeUpdateBatch(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs, EdgeUpdateBatch& batch) const
+{
+	//Repeated IDs would be added to or removed from the nodes twice
+	batch.edgeIDs = edgeIDs;
+	std::sort(batch.edgeIDs.begin(), batch.edgeIDs.end());
+	batch.edgeIDs.erase(std::unique(batch.edgeIDs.begin(), batch.edgeIDs.end()), batch.edgeIDs.end());
+
+	for (unsigned int i = 0; i < batch.edgeIDs.size(); ++i)
+	{
+		const unsigned int numOppositeVertices = edges.getNumOppositeVertices(batch.edgeIDs[i]);
+
+		assert(numOppositeVertices <= 2);
+
+		if (numOppositeVertices == 1)
+			batch.openEdgeIDs.push_back(batch.edgeIDs[i]);
+
+		if (numOppositeVertices != 2)
+			continue;
+
+		batch.traversedEdges.push_back(i);
 	}
 }
 
-void OctreeVisitor::_processSilhouetteEdgesInLevel(unsigned int level)
+void OctreeVisitor::_collectInsertedLeafBlockEdges(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int startingID, const std::vector<unsigned int>& batchEdges, std::vector<int> (&childResults)[OCTREE_NUM_CHILDREN], std::vector< std::vector<NodeEdgeUpdate> >& updates) const
 {
-	assert(level > 0);
-	const int startingID = _getFirstNodeIdInLevel(level);
+	OctreeLeafBlock block;
+	_initLeafBlock(startingID, block);
 
-	assert(startingID >= 0);
+	NodeEdgeUpdate leafUpdates[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN];
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		childResults[i].resize(batchEdges.size());
 
-	const int stopId = ipow(OCTREE_NUM_CHILDREN, level) + startingID;
+		for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
+		{
+			leafUpdates[i][j].nodeID = block.leafStartingIDs[i] + j;
+			leafUpdates[i][j].node.volume = _octree->calculateNodeVolume(block.leafStartingIDs[i] + j);
+		}
+	}
 
-	int currentID = startingID;
+	EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
 
-	#pragma omp parallel for
-	for (currentID = startingID; currentID<stopId; currentID += OCTREE_NUM_CHILDREN)
+	for (size_t e = 0; e < batchEdges.size(); ++e)
 	{
-		std::set<int> silhouetteEdgesSyblings;
-		_getAllSilhouetteEdgesSyblings(currentID, silhouetteEdgesSyblings);
+		const unsigned int edgeID = batch.edgeIDs[batchEdges[e]];
+		block.lattice.classifyEdge(edges, edgeID, block.cellResults);
 
-		for (auto edge : silhouetteEdgesSyblings)
+		//Same as visiting the child, whose leaves have nothing to propagate
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 		{
-			auto result = _haveAllSyblingsEdgeAsPotential(currentID, edge);
+			const EdgeSilhouetness firstResult = block.cellResults[block.leafCells[i][0]];
+
+			bool isSameInAllLeaves = true;
+			for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
+			{
+				const EdgeSilhouetness testResult = block.cellResults[block.leafCells[i][j]];
+				edgeTests.add(testResult);
+				isSameInAllLeaves &= testResult == firstResult;
+			}
 
-			if (result == TestResult::TRUE)
+			if (isSameInAllLeaves)
 			{
-				_assignSilhouetteEdgeToNodeParent(currentID, edge);
-				_removeSilhouetteEdgeFromSyblings(currentID, edge);
+				childResults[i][e] = int(firstResult);
+				continue;
 			}
+
+			childResults[i][e] = OCTREE_MIXED_SUBTREE_RESULT;
+
+			for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
+				_addEdgeResult(leafUpdates[i][j].node, edgeID, int(block.cellResults[block.leafCells[i][j]]));
+		}
+	}
+
+	std::vector<NodeEdgeUpdate>& workerUpdates = updates[_threadPool->getCurrentWorkerIndex()];
+
+	for (auto& childLeaves : leafUpdates)
+	{
+		for (auto& update : childLeaves)
+		{
+			if (!update.node.edgesMayCast.empty() || !update.node.edgesAlwaysCast.empty())
+				workerUpdates.push_back(std::move(update));
 		}
 	}
 }
 
-int	OctreeVisitor::_getFirstNodeIdInLevel(unsigned int level) const
+bool OctreeVisitor::_hasChildrenToVisit(unsigned int nodeID) const
 {
-	return _octree->getNumNodesInPreviousLevels(level);
+	if (_isAdaptive)
+		return _octree->childrenExist(nodeID);
+
+	return _octree->getChildrenStartingId(nodeID) >= 0;
 }
 
-void OctreeVisitor::_getAllPotentialEdgesSyblings(unsigned int startingID, std::set<unsigned int>& edges) const
+void OctreeVisitor::_collectInsertedEdges(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int nodeID, const AABB& volume, const std::vector<unsigned int>& batchEdges, std::vector<int>& results, std::vector< std::vector<NodeEdgeUpdate> >& updates) const
 {
-	for(unsigned int i=0; i<OCTREE_NUM_CHILDREN; ++i)
+	const bool hasChildren = _hasChildrenToVisit(nodeID);
+
+	EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
+
+	//Positions within batchEdges and results of the edges passed to the children
+	std::vector<unsigned int> childEdges;
+	std::vector<unsigned int> childEdgePositions;
+
+	results.resize(batchEdges.size());
+
+	for (size_t i = 0; i < batchEdges.size(); ++i)
 	{
-		const auto node = _octree->getNode(startingID + i);
+		const unsigned int edge = batchEdges[i];
+		const EdgeSilhouetness testResult = GeometryOps::testEdgeSpaceAabb(edges, batch.edgeIDs[edge], volume);
+		edgeTests.add(testResult);
 
-		if(node!=nullptr)
-			edges.insert(node->edgesMayCast.begin(), node->edgesMayCast.end());
+		results[i] = int(testResult);
+
+		if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE && hasChildren)
+		{
+			childEdges.push_back(edge);
+			childEdgePositions.push_back(static_cast<unsigned int>(i));
+		}
 	}
-}
 
-void OctreeVisitor::_getAllSilhouetteEdgesSyblings(unsigned int startingID, std::set<int>& edges) const
-{
-	for (unsigned int i = 0; i<OCTREE_NUM_CHILDREN; ++i)
+	if (childEdges.empty())
+		return;
+
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
+	const glm::vec3 splitPoint = _isAdaptive ? _octree->getNodeSplitPoint(nodeID) : volume.getCenterPoint();
+
+	NodeEdgeUpdate childUpdates[OCTREE_NUM_CHILDREN];
+	std::vector<int> childResults[OCTREE_NUM_CHILDREN];
+
+	//Leaves below the children are classified as one lattice instead of visiting the children
+	const bool isLeafBlock = !_isAdaptive && _octree->getNodeRecursionLevel(startingChild) + 1 == int(_octree->getDeepestLevel());
+
+	BuildThreadPool::TaskGroup childTasks(*_threadPool);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		const auto node = _octree->getNode(startingID + i);
+		//Same volumes as the build, existing children of adaptive nodes may be split off-center
+		const Node* child = _octree->getNode(startingChild + i);
+
+		childUpdates[i].nodeID = startingChild + i;
+		if (child)
+			childUpdates[i].node.volume = child->volume;
+		else
+			childUpdates[i].node.volume = _isAdaptive ? Octree::getChildVolume(volume, i, splitPoint) : Octree::getChildVolume(volume, i);
 
-		if (node != nullptr)
-			edges.insert(node->edgesAlwaysCast.begin(), node->edgesAlwaysCast.end());
+		if (isLeafBlock)
+			continue;
+
+		const AABB* childVolume = &childUpdates[i].node.volume;
+		std::vector<int>* childResult = &childResults[i];
+		childTasks.run([this, &edges, &batch, &childEdges, &updates, childVolume, childResult, startingChild, i]()
+		{
+			_collectInsertedEdges(edges, batch, startingChild + i, *childVolume, childEdges, *childResult, updates);
+		});
 	}
-}
 
-void OctreeVisitor::_removePotentialEdgeFromSyblings(unsigned int startingID, unsigned int edge)
-{
-	for(unsigned int i=0; i<OCTREE_NUM_CHILDREN; ++i)
+	if (isLeafBlock)
+		_collectInsertedLeafBlockEdges(edges, batch, startingChild, childEdges, childResults, updates);
+
+	childTasks.wait();
+
+	//Mirrors the propagation, an edge ends in the highest node below which it is classified the same everywhere
+	for (size_t e = 0; e < childEdges.size(); ++e)
 	{
-		auto node = _octree->getNode(startingID + i);
+		const int firstResult = childResults[0][e];
+
+		bool isSameInAllChildren = firstResult != OCTREE_MIXED_SUBTREE_RESULT;
+		for (unsigned int i = 1; i < OCTREE_NUM_CHILDREN; ++i)
+			isSameInAllChildren &= childResults[i][e] == firstResult;
+
+		if (isSameInAllChildren)
+		{
+			results[childEdgePositions[e]] = firstResult;
+			continue;
+		}
+
+		results[childEdgePositions[e]] = OCTREE_MIXED_SUBTREE_RESULT;
 
-		if(node)
-			node->edgesMayCast.erase(std::find(node->edgesMayCast.begin(), node->edgesMayCast.end(), edge));
+		for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+			_addEdgeResult(childUpdates[i].node, batch.edgeIDs[childEdges[e]], childResults[i][e]);
 	}
-}
 
-void OctreeVisitor::_removeSilhouetteEdgeFromSyblings(unsigned int startingID, int edge)
-{
-	for (unsigned int i = 0; i<OCTREE_NUM_CHILDREN; ++i)
-	{
-		auto node = _octree->getNode(startingID + i);
+	std::vector<NodeEdgeUpdate>& workerUpdates = updates[_threadPool->getCurrentWorkerIndex()];
 
-		if (node)
-			node->edgesAlwaysCast.erase(std::find(node->edgesAlwaysCast.begin(), node->edgesAlwaysCast.end(), edge));
+	for (auto& update : childUpdates)
+	{
+		if (!update.node.edgesMayCast.empty() || !update.node.edgesAlwaysCast.empty())
+			workerUpdates.push_back(std::move(update));
 	}
 }
 
-void OctreeVisitor::_assignPotentialEdgeToNodeParent(unsigned int node, unsigned int edge)
+void OctreeVisitor::_addEdgeResult(Node& node, unsigned int edgeID, int result)
+{
+	if (result == int(EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE))
+		node.edgesMayCast.push_back(edgeID);
+	else if (result == int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS))
+		node.edgesAlwaysCast.push_back(encodeSilhouetteEdge(edgeID, 1));
+	else if (result == int(EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS))
+		node.edgesAlwaysCast.push_back(encodeSilhouetteEdge(edgeID, -1));
+}
+
+void OctreeVisitor::_applyNodeEdgeUpdates(std::vector< std::vector<NodeEdgeUpdate> >& updates)
 {
-	const int parent = _octree->getNodeParent(node);
+	std::vector<NodeEdgeUpdate*> nodeUpdates;
+	for (auto& workerUpdates : updates)
+	{
+		for (auto& update : workerUpdates)
+			nodeUpdates.push_back(&update);
+	}
 
-	assert(parent >= 0);
+	//Materialization modifies the level maps, the only serial part, node pointers stay valid afterwards
+	std::vector<Node*> nodes(nodeUpdates.size());
+	for (size_t i = 0; i < nodeUpdates.size(); ++i)
+	{
+		nodes[i] = _octree->getNode(nodeUpdates[i]->nodeID);
+
+		if (!nodes[i])
+		{
+			nodes[i] = _octree->materializeNode(nodeUpdates[i]->nodeID);
+			nodes[i]->volume = nodeUpdates[i]->node.volume;
+		}
+	}
 
-	auto n = _octree->getNode(parent);
+	//Every node has at most one update
+	_threadPool->parallelFor(0, int(nodeUpdates.size()), 64, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			Node& update = nodeUpdates[i]->node;
+			update.sortEdgeVectors();
 
-	if (n)
-		n->edgesMayCast.push_back(edge);
+			mergeSortedEdges(nodes[i]->edgesMayCast, update.edgesMayCast);
+			mergeSortedEdges(nodes[i]->edgesAlwaysCast, update.edgesAlwaysCast);
+			nodes[i]->shrinkEdgeVectors();
+		}
+	});
 }
 
-void OctreeVisitor::_assignSilhouetteEdgeToNodeParent(unsigned int node, int edge)
+void OctreeVisitor::_removeEdgesFromSubtree(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int nodeID, Node& node, const std::vector<unsigned int>& batchEdges, std::vector< std::vector<unsigned int> >& touchedNodes)
 {
-	const int parent = _octree->getNodeParent(node);
+	const int startingChild = _octree->getChildrenStartingId(nodeID);
 
-	assert(parent >= 0);
+	EdgeTestCounters& edgeTests = _getWorkerEdgeTests();
 
-	auto n = _octree->getNode(parent);
+	//Same classification as when the edges were inserted, an edge is never stored where it is not silhouette
+	//Searching the lists for each edge would cost more than filtering them once with all edges that may be stored here
+	std::vector<unsigned int> removedEdges;
+	std::vector<unsigned int> childEdges;
 
-	if (n)
-		n->edgesAlwaysCast. push_back(edge);
-}
+	for (const auto edge : batchEdges)
+	{
+		const EdgeSilhouetness testResult = GeometryOps::testEdgeSpaceAabb(edges, batch.edgeIDs[edge], node.volume);
+		edgeTests.add(testResult);
 
-//NEVOLAT!
-void OctreeVisitor::cleanEmptyNodes()
-{
-	/*const int startingID = _getFirstNodeIdInLevel(_octree->getDeepestLevel());
-	const int bottomLevelSize = ipow(OCTREE_NUM_CHILDREN, _octree->getDeepestLevel());
+		if (testResult == EdgeSilhouetness::EDGE_NOT_SILHOUETTE)
+			continue;
+
+		removedEdges.push_back(batch.edgeIDs[edge]);
+
+		if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE && startingChild >= 0)
+			childEdges.push_back(edge);
+	}
 
-	for(int i = startingID; i<(startingID + bottomLevelSize); ++i)
+	if (!removedEdges.empty())
 	{
-		auto node = _octree->getNode(i);
+		auto& mayCast = node.edgesMayCast;
+		mayCast.erase(std::set_difference(mayCast.begin(), mayCast.end(), removedEdges.begin(), removedEdges.end(), mayCast.begin()), mayCast.end());
 
-		if (node && !node->edgesAlwaysCast.size() && !node->edgesMayCast.size())
-			_octree->deleteNodeSubtree(i);
-	}*/
+		auto& alwaysCast = node.edgesAlwaysCast;
+		alwaysCast.erase(std::remove_if(alwaysCast.begin(), alwaysCast.end(), [&removedEdges](int edge)
+		{
+			return std::binary_search(removedEdges.begin(), removedEdges.end(), decodeSilhouetteEdgeID(edge));
+		}), alwaysCast.end());
+
+		touchedNodes[_threadPool->getCurrentWorkerIndex()].push_back(nodeID);
+	}
 
-	for(unsigned int level = _octree->getDeepestLevel(); level>0; --level)
+	if (childEdges.empty())
+		return;
+
+	BuildThreadPool::TaskGroup childTasks(*_threadPool);
+
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		_processEmptyNodesInLevel(level);
+		Node* child = _octree->getNode(startingChild + i);
+
+		if (child)
+			childTasks.run([this, &edges, &batch, &childEdges, &touchedNodes, child, startingChild, i]() { _removeEdgesFromSubtree(edges, batch, startingChild + i, *child, childEdges, touchedNodes); });
 	}
+
+	childTasks.wait();
 }
 
-void OctreeVisitor::_processEmptyNodesInLevel(unsigned int level)
+void OctreeVisitor::_removeEmptyLeaves(const std::vector<unsigned int>& nodeIDs)
 {
-	assert(level > 0);
-	const int startingID = _getFirstNodeIdInLevel(level);
+	//Deepest nodes first, their parents can become empty leaves only after them
+	for (auto it = nodeIDs.rbegin(); it != nodeIDs.rend(); ++it)
+	{
+		unsigned int nodeID = *it;
+		const Node* node = _octree->getNode(nodeID);
 
-	assert(startingID >= 0);
+		while (nodeID != 0 && node && node->edgesMayCast.empty() && node->edgesAlwaysCast.empty() && !_octree->childrenExist(nodeID))
+		{
+			_octree->deleteNode(nodeID);
 
-	const unsigned int stopId = ipow(OCTREE_NUM_CHILDREN, level) + startingID;
+			nodeID = _octree->getNodeParent(nodeID);
+			node = _octree->getNode(nodeID);
+		}
+	}
+}
 
-	unsigned int currentID = startingID;
+bool OctreeVisitor::_materializeChildren(unsigned int startingID, Node (&children)[OCTREE_NUM_CHILDREN], const bool (&childHasChildren)[OCTREE_NUM_CHILDREN])
+{
+	bool hasChildren = false;
 
-	const unsigned int deepestLevel = _octree->getDeepestLevel();
+	std::lock_guard<std::mutex> lock(_octreeMutex);
 
-	while (currentID < stopId)
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
 	{
-		_processEmptyNodesSyblingsParent(currentID);
+		if (!childHasChildren[i] && children[i].edgesMayCast.empty() && children[i].edgesAlwaysCast.empty())
+			continue;
 
-		currentID += OCTREE_NUM_CHILDREN;
+		Node* child = _octree->materializeNode(startingID + i);
+		child->edgesMayCast.swap(children[i].edgesMayCast);
+		child->edgesAlwaysCast.swap(children[i].edgesAlwaysCast);
+		child->shrinkEdgeVectors();
+
+		hasChildren = true;
 	}
+
+	return hasChildren;
 }
 
-void OctreeVisitor::_processEmptyNodesSyblingsParent(unsigned int first)
+void OctreeVisitor::_initLeafBlock(unsigned int startingID, OctreeLeafBlock& block) const
 {
-	unsigned int numRemoved = 0;
-	
-	for(unsigned int i=0; i<OCTREE_NUM_CHILDREN; ++i)
-	{
-		auto node = _octree->getNode(first + i);
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+		block.leafStartingIDs[i] = _octree->getChildrenStartingId(startingID + i);
 
-		if(node && !node->edgesMayCast.size() && !node->edgesAlwaysCast.size())
+	//Bit k of a child index selects the upper half along axis k
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
 		{
-			_octree->deleteNode(first + i);
-			++numRemoved;
+			unsigned int cell = 0;
+			for (int axis = LATTICE_CLASSIFIER_NUM_AXES - 1; axis >= 0; --axis)
+				cell = cell * OCTREE_LEAF_BLOCK_SIZE + (((i >> axis) & 1) << 1) + ((j >> axis) & 1);
+
+			block.leafCells[i][j] = cell;
 		}
-		else
-			++numRemoved;
 	}
 
-	if(numRemoved==OCTREE_NUM_CHILDREN)
+	for (unsigned int axis = 0; axis < LATTICE_CLASSIFIER_NUM_AXES; ++axis)
 	{
-		const int parentID = _octree->getNodeParent(first);
-		auto parent = _octree->getNode(parentID);
+		std::vector<float> lower(OCTREE_LEAF_BLOCK_SIZE);
+		std::vector<float> upper(OCTREE_LEAF_BLOCK_SIZE);
 
-		if (parent && !parent->edgesMayCast.size() && !parent->edgesAlwaysCast.size())
-			_octree->deleteNode(parentID);
+		for (unsigned int p = 0; p < OCTREE_LEAF_BLOCK_SIZE; ++p)
+		{
+			const AABB volume = _octree->calculateNodeVolume(block.leafStartingIDs[(p >> 1) << axis] + ((p & 1) << axis));
+			lower[p] = volume.getMinPoint()[axis];
+			upper[p] = volume.getMaxPoint()[axis];
+		}
+
+		block.lattice.setAxis(axis, lower, upper);
 	}
 }
 
-void OctreeVisitor::_expandWholeOctree()
+void OctreeVisitor::_addLeafBlockEdge(const EdgeStore& edges, unsigned int edgeID, OctreeLeafBlock& block, ArenaEdgeLists (&leafLists)[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN], ArenaEdgeLists (&childLists)[OCTREE_NUM_CHILDREN], EdgeTestCounters& edgeTests) const
 {
-	std::stack<unsigned int> nodeStack;
+	block.lattice.classifyEdge(edges, edgeID, block.cellResults);
 
-	nodeStack.push(0);
+	for (unsigned int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
+	{
+		EdgeSilhouetness testResults[OCTREE_NUM_CHILDREN];
+		for (unsigned int j = 0; j < OCTREE_NUM_CHILDREN; ++j)
+			testResults[j] = block.cellResults[block.leafCells[i][j]];
 
-	const int deepestLevel = _octree->getDeepestLevel();
+		_addSyblingEdgeResults(edgeID, block.leafStartingIDs[i], testResults, leafLists[i], childLists[i], edgeTests);
+	}
+}
+
+void OctreeVisitor::_addSyblingEdgeResults(unsigned int edgeIndex, unsigned int startingID, const EdgeSilhouetness (&testResults)[OCTREE_NUM_CHILDREN], ArenaEdgeLists* syblingLists, ArenaEdgeLists& parentLists, EdgeTestCounters& edgeTests) const
+{
+	unsigned int numPotential = 0;
+	unsigned int numSilhouette = 0;
 
-	while(!nodeStack.empty())
+	int potentialIndices[OCTREE_NUM_CHILDREN];
+	int silhouetteIndices[OCTREE_NUM_CHILDREN];
+
+	for (unsigned int index = startingID; index<(startingID + OCTREE_NUM_CHILDREN); index++)
 	{
-		const auto node = nodeStack.top();
-		nodeStack.pop();
+		const EdgeSilhouetness testResult = testResults[index - startingID];
+		edgeTests.add(testResult);
 
-		_octree->splitNode(node);
+		if (testResult== EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS)
+			silhouetteIndices[numSilhouette++] = index;
+		else if (testResult == EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS)
+			silhouetteIndices[numSilhouette++] = -int(index);
+		else if (testResult == EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE)
+			potentialIndices[numPotential++] = index;
+	}
 
-		const auto level = _octree->getNodeRecursionLevel(node);
+	if (numPotential == OCTREE_NUM_CHILDREN)
+	{
+		parentLists.mayCast.push_back(edgeIndex);
+		numPotential = 0;
+	}
 
-		if (level < (deepestLevel-1))
+	if (numSilhouette == OCTREE_NUM_CHILDREN)
+	{
+		const bool sameFacing = _doAllSilhouetteFaceTheSame(silhouetteIndices);
+
+		if (sameFacing)
 		{
-			const auto startingChild = _octree->getChildrenStartingId(node);
-			for (int i = 0; i < OCTREE_NUM_CHILDREN; ++i)
-				nodeStack.push(startingChild + i);
+			const int sign = silhouetteIndices[0] < 0 ? -1 : 1;
+			parentLists.alwaysCast.push_back(encodeSilhouetteEdge(edgeIndex, sign));
+			numSilhouette = 0;
 		}
 	}
 
-	_octree->makeNodesFit();
+	for(unsigned int i = 0; i<numPotential; ++i)
+		syblingLists[potentialIndices[i] - startingID].mayCast.push_back(edgeIndex);
+
+	for (unsigned int i = 0; i<numSilhouette; ++i)
+		syblingLists[abs(silhouetteIndices[i]) - startingID].alwaysCast.push_back(encodeSilhouetteEdge(edgeIndex, silhouetteIndices[i] < 0 ? -1 : 1));
 }
 
+bool OctreeVisitor::_doAllSilhouetteFaceTheSame(const int(&indices)[OCTREE_NUM_CHILDREN]) const
+{
+	const bool isFirst = indices[0]>0;
+
+	for(unsigned int i = 1; i<OCTREE_NUM_CHILDREN; ++i)
+	{
+		const bool current = indices[i] > 0;
+
+		if (isFirst != current)
+			return false;
+	}
+
+	return true;
+}
+
+
 int OctreeVisitor::getLowestNodeIndexFromPoint(const glm::vec3& point) const
 {
-	int currentParent = 0;
+	if (!_isPointInsideNode(0, point))
+		return -1;
+
+	int currentNode = 0;
 	const unsigned int deepestLevel = _octree->getDeepestLevel();
 
-	for(unsigned int level = 0; level<deepestLevel && currentParent>=0; ++level)
-		currentParent = _getChildNodeContainingPoint(currentParent, point);
+	//Descends as long as the nodes exist, missing nodes hold no edges
+	for(unsigned int level = 0; level<deepestLevel; ++level)
+	{
+		const int child = _getChildNodeContainingPoint(currentNode, point);
+
+		if (child < 0)
+			break;
 
-	return currentParent;
+		currentNode = child;
+	}
+
+	return currentNode;
 }
 
 bool OctreeVisitor::_isPointInsideNode(unsigned int nodeID, const glm::vec3& point) const
@@ -547,14 +1344,70 @@ bool OctreeVisitor::_isPointInsideNode(unsigned int nodeID, const glm::vec3& poi
 int OctreeVisitor::_getChildNodeContainingPoint(unsigned int parent, const glm::vec3& point) const
 {
 	const int startingID = _octree->getChildrenStartingId(parent);
+	const glm::vec3 centerPoint = _octree->getNodeVolume(parent).getCenterPoint();
+
+	const int childIndex = (point.x >= centerPoint.x) + 2 * (point.y >= centerPoint.y) + 4 * (point.z >= centerPoint.z);
+
+	if (!_octree->nodeExists(startingID + childIndex))
+		return -1;
 
-	for(unsigned int i=0; i<OCTREE_NUM_CHILDREN; ++i)
+	return startingID + childIndex;
+}
+
+void OctreeVisitor::_printThreadPoolStats()
+{
+	std::vector<BuildThreadPool::WorkerStats> stats;
+	_threadPool->getWorkerStats(stats);
+
+	for (size_t i = 0; i < stats.size(); ++i)
+		std::cout << "Worker " << i << " busy " << stats[i].busySeconds << " sec, idle " << stats[i].idleSeconds << " sec, " << stats[i].numTasks << " tasks (" << stats[i].numStolenTasks << " stolen)\n";
+}
+
+BuildArena& OctreeVisitor::_getWorkerArena() const
+{
+	return _workerArenas[_threadPool->getCurrentWorkerIndex()];
+}
+
+void OctreeVisitor::_releaseWorkerArenas()
+{
+	size_t numReservedBytes = 0;
+
+	for (auto& arena : _workerArenas)
+	{
+		numReservedBytes += arena.getNumReservedBytes();
+		arena.release();
+	}
+
+	std::cout << "Build arenas reserved " << numReservedBytes / 1024.0 / 1024.0 << "MB\n";
+}
+
+EdgeTestCounters& OctreeVisitor::_getWorkerEdgeTests() const
+{
+	return _workerEdgeTests[_threadPool->getCurrentWorkerIndex()];
+}
+
+void OctreeVisitor::_collectWorkerEdgeTests()
+{
+	for (auto& counters : _workerEdgeTests)
 	{
-		if (_isPointInsideNode(startingID + i, point))
-			return startingID + i;
+		_buildReport.addEdgeTests(counters);
+		counters.clear();
 	}
+}
 
-	return -1;
+void OctreeVisitor::setCancelFlag(const std::atomic<bool>* cancelFlag)
+{
+	_cancelFlag = cancelFlag;
+}
+
+bool OctreeVisitor::isBuildCancelled() const
+{
+	return _cancelFlag && _cancelFlag->load(std::memory_order_relaxed);
+}
+
+const BuildReport& OctreeVisitor::getBuildReport() const
+{
+	return _buildReport;
 }
 
 void OctreeVisitor::getSilhouttePotentialEdgesFromNodeUp(std::vector<int>& potential, std::vector<int>& silhouette, unsigned int nodeID) const
@@ -570,8 +1423,6 @@ void OctreeVisitor::getSilhouttePotentialEdgesFromNodeUp(std::vector<int>& poten
 		silhouette.insert(silhouette.end(), node->edgesAlwaysCast.begin(), node->edgesAlwaysCast.end());
 		potential.insert(potential.end(), node->edgesMayCast.begin(), node->edgesMayCast.end());
 
-		std::cout << "Getting " << node->edgesAlwaysCast.size() << " silhouette and " << node->edgesMayCast.size() << " potential from node " << currentNodeID << std::endl;
-
 		currentNodeID = _octree->getNodeParent(currentNodeID);
 	}
 }
\ No newline at end of file
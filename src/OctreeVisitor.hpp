@@ -1,68 +1,185 @@
 #pragma once
 
 #include "Octree.hpp"
-#include "Edge.hpp"
+#include "EdgeStore.hpp"
 #include "GeometryOperations.hpp"
+#include "BuildThreadPool.hpp"
+#include "BuildArena.hpp"
+#include "BuildReport.hpp"
+#include <atomic>
 #include <memory>
-#include <set>
+#include <mutex>
+#include <string>
+
+class OctreeNodeStore;
+struct ArenaEdgeLists;
+struct OctreeLeafBlock;
+
+enum class OctreeSplitPlacement
+{
+	MIDPOINT,
+	EDGE_MEDIAN		//median of the potential edges' positions, clamped to the middle half of the node
+};
+
+struct AdaptiveSubdivisionParams
+{
+	AdaptiveSubdivisionParams() : maxPotentialEdgesPerNode(256), splitCostPerStoredEdge(0.01f), splitPlacement(OctreeSplitPlacement::MIDPOINT) {}
+
+	//Nodes with fewer potential edges are never split
+	unsigned int			maxPotentialEdgesPerNode;
+	//A split has to save at least this many potential edges per query for every edge stored in the new children
+	float					splitCostPerStoredEdge;
+	OctreeSplitPlacement	splitPlacement;
+};
+
+struct StreamingBuildParams
+{
+	StreamingBuildParams() : memoryBudgetBytes(uint64_t(256) << 20), edgeChunkSize(1 << 16), spillPathPrefix("octree_spill") {}
+
+	//Subtrees are expanded in memory only if their estimated size fits, larger ones are split and their children built one at a time
+	uint64_t		memoryBudgetBytes;
+	//Edges classified together in the levels above the in-memory subtrees
+	unsigned int	edgeChunkSize;
+	//Finished nodes are spilled to files named pathPrefix.levelN
+	std::string		spillPathPrefix;
+};
 
 class OctreeVisitor
 {
 public:
 	OctreeVisitor(std::shared_ptr<Octree> octree);
 
-	void addEdge(const EDGE_TYPE& edgeInfo, int edgeID);
-	void addEdges(const EDGE_CONTAINER_TYPE& _edges);
+	//Top-down build, subdivides only where it pays off, up to the octree's deepest level
+	void addEdgesAdaptive(const EdgeStore& edges, const AdaptiveSubdivisionParams& params);
+	//Post-order build, an edge is only tested in the children of nodes where it is potentially silhouette,
+	//edges common to all 8 children are moved to the parent as soon as the children are done
+	void addEdgesTopDown(const EdgeStore& edges);
+	//Same lists as addEdgesTopDown, but finished nodes go to the store instead of the octree, which stays empty
+	//Only one path of subtrees is held in memory at a time, each small enough for the memory budget
+	void addEdgesStreaming(const EdgeStore& edges, const StreamingBuildParams& params, OctreeNodeStore& store);
 
-	void processPotentialEdges();
-
-	void cleanEmptyNodes();
+	//Change a built octree in place, edges are indexed by their IDs and only the listed ones are processed
+	//Only subtrees where an edge is potentially silhouette are visited, lists end up the same as when building from the changed edges
+	void insertEdges(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs);
+	//The edges have to have the geometry they were inserted with
+	void removeEdges(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs);
 
 	int getLowestNodeIndexFromPoint(const glm::vec3& point) const;
 	void getSilhouttePotentialEdgesFromNodeUp(std::vector<int>& potential, std::vector<int>& silhouette, unsigned int nodeID) const;
 
+	//Phases and edge test outcomes of the builds run since the visitor was created
+	const BuildReport& getBuildReport() const;
+
+	//Builds check the flag in every node and stop once it is set, leaving an incomplete octree
+	void setCancelFlag(const std::atomic<bool>* cancelFlag);
+	bool isBuildCancelled() const;
+
 private:
-	void _expandWholeOctree();
-	void _storeEdgeIsAlwaysSilhouette(EdgeSilhouetness testResult, unsigned int nodeId, unsigned int edgeID);
-	void _storeEdgeIsAlwaysSilhouette(unsigned int nodeId, int augmentedEdgeIdWithResult);
-	void _storeEdgeIsPotentiallySilhouette(unsigned int nodeID, unsigned int edgeID);
-
-	//void _unmarkEdgeAsPotentiallySilhouetteFromNodeUp(unsigned int edgeID, unsigned int nodeID);
-	//void _removePotentiallySilhouetteEdgeFromNode(unsigned int edgeID, unsigned int nodeID);
-	
-	int	 _getFirstNodeIdInLevel(unsigned int level) const;
-
-	void _propagatePotentiallySilhouetteEdgesUpFromLevel(unsigned int startingLevel);
-		enum class TestResult
-		{
-			TRUE,
-			FALSE,
-			NON_EXISTING
-		};
-
-		TestResult _haveAllSyblingsEdgeAsPotential(unsigned int startingNodeID, unsigned int edgeID) const;
-		void _processPotentialEdgesInLevel(unsigned int levelNum);
-		void _getAllPotentialEdgesSyblings(unsigned int startingID, std::set<unsigned int>& edges) const;
-		void _assignPotentialEdgeToNodeParent(unsigned int node, unsigned int edge);
-		void _removePotentialEdgeFromSyblings(unsigned int startingID, unsigned int edge);
-	
-	void _propagateSilhouetteEdgesUpFromLevel(unsigned int startingLevel);
-		void _processSilhouetteEdgesInLevel(unsigned int level);
-		void _assignSilhouetteEdgeToNodeParent(unsigned int node, int edge);
-		void _getAllSilhouetteEdgesSyblings(unsigned int startingID, std::set<int>& edges) const;
-		void _removeSilhouetteEdgeFromSyblings(unsigned int startingID, int edge);
-
-	void _processEmptyNodesInLevel(unsigned int level);
-		void _processEmptyNodesSyblingsParent(unsigned int first);
-
-	void _addEdgesOnLowestLevel(std::vector< std::vector<Plane> >& edgePlanes, const EDGE_CONTAINER_TYPE& edges);
-		void _addEdgesSyblingsParent(const std::vector< std::vector<Plane> >& edgePlanes, const EDGE_CONTAINER_TYPE& edges, unsigned int startingID);
-		void _generateEdgePlanes(const EDGE_CONTAINER_TYPE& edges, std::vector< std::vector<Plane> >& planes) const;
-		bool _doAllSilhouetteFaceTheSame(const int (&indices)[OCTREE_NUM_CHILDREN]) const;
+	//Leaves below the 8 children starting at startingID, classified as one lattice
+	void _initLeafBlock(unsigned int startingID, OctreeLeafBlock& block) const;
+	//Adds the edge to the lists of the leaves, or of their parent child where all of its leaves have the same result
+	void _addLeafBlockEdge(const EdgeStore& edges, unsigned int edgeID, OctreeLeafBlock& block, ArenaEdgeLists (&leafLists)[OCTREE_NUM_CHILDREN][OCTREE_NUM_CHILDREN], ArenaEdgeLists (&childLists)[OCTREE_NUM_CHILDREN], EdgeTestCounters& edgeTests) const;
+	//Adds the edge to the lists of the syblings, or of their parent where all of them have the same result
+	void _addSyblingEdgeResults(unsigned int edgeIndex, unsigned int startingID, const EdgeSilhouetness (&testResults)[OCTREE_NUM_CHILDREN], ArenaEdgeLists* syblingLists, ArenaEdgeLists& parentLists, EdgeTestCounters& edgeTests) const;
+	bool _doAllSilhouetteFaceTheSame(const int (&indices)[OCTREE_NUM_CHILDREN]) const;
+	//Moves the finished children into the octree, drained and empty ones are dropped, returns if any was kept
+	bool _materializeChildren(unsigned int startingID, Node (&children)[OCTREE_NUM_CHILDREN], const bool (&childHasChildren)[OCTREE_NUM_CHILDREN]);
+
+	struct BuildNode
+	{
+		BuildNode() : hasStoredChildren(false) {}
+
+		Node node;
+		std::unique_ptr<BuildNode> children[OCTREE_NUM_CHILDREN];
+		//Children already moved into the octree
+		bool hasStoredChildren;
+	};
+
+	void _classifyEdgesInRoot(const EdgeStore& edges, BuildNode& root, std::vector<unsigned int>& openEdges, std::vector<unsigned int>& potentialEdges) const;
+	void _buildAdaptiveSubtree(BuildNode& buildNode, unsigned int level, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, const AdaptiveSubdivisionParams& params) const;
+		glm::vec3 _getAdaptiveSplitPoint(const AABB& volume, const std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, OctreeSplitPlacement placement) const;
+	//Stored children go to the octree as soon as they are final and their build nodes are freed, others are left in the build node
+	void _buildCulledSubtree(BuildNode& buildNode, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren);
+		void _buildCulledChildren(BuildNode& buildNode, unsigned int startingChild, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren);
+		//Children have to be one level above the leaves, the leaves of the subtree are built right away
+		void _buildCulledLeafBlock(BuildNode& buildNode, unsigned int startingChild, std::vector<unsigned int>& potentialEdges, const EdgeStore& edges, bool storeChildren);
+		void _moveCommonChildEdgesToParent(BuildNode& buildNode) const;
+		void _removeEmptyLeafChildren(BuildNode& buildNode) const;
+		void _storeFinishedChildren(BuildNode& buildNode, unsigned int startingID);
+	void _storeBuildSubtree(BuildNode& buildNode, unsigned int nodeID);
+
+	struct StreamingBuild
+	{
+		const EdgeStore&	edges;
+		const StreamingBuildParams&	params;
+		OctreeNodeStore&			store;
+
+		uint64_t					numInMemorySubtrees;
+		uint64_t					largestSubtreeBytes;
+	};
+
+	//Edges are classified chunk by chunk, results are in the order of edgeIDs
+	void _classifyEdgeChunks(const StreamingBuild& build, const std::vector<unsigned int>& edgeIDs, const AABB& volume, std::vector<unsigned int>& potentialEdges, std::vector<int>& silhouetteEdges) const;
+	//Leaves the node's lists sorted, without the edges moved to its parent later, returns whether it has children
+	bool _buildStreamedSubtree(StreamingBuild& build, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, Node& node);
+	bool _buildSubtreeInMemory(StreamingBuild& build, unsigned int nodeID, std::vector<unsigned int>& potentialEdges, Node& node);
+		void _spillBuildSubtree(BuildNode& buildNode, unsigned int nodeID, const std::vector<unsigned int>& edgeIDs, OctreeNodeStore& store, uint64_t& numBytes) const;
+	//Upper bound of the memory of an in-memory subtree build
+	static uint64_t _estimateSubtreeBytes(size_t numPotentialEdges, unsigned int numLevelsBelow);
+
+	struct EdgeUpdateBatch
+	{
+		//Sorted, edges are referred to by their position here
+		std::vector<unsigned int> edgeIDs;
+		//Only edges with two neighbouring triangles are traversed
+		std::vector<unsigned int> traversedEdges;
+		//Edges with one neighbouring triangle, potentially silhouette in the root
+		std::vector<unsigned int> openEdgeIDs;
+	};
+
+	struct NodeEdgeUpdate
+	{
+		unsigned int nodeID;
+		Node node;
+	};
+
+	void _prepareEdgeUpdateBatch(const EdgeStore& edges, const std::vector<unsigned int>& edgeIDs, EdgeUpdateBatch& batch) const;
+	//Adaptive octrees keep their subdivision, full-depth ones are descended to the deepest level
+	bool _hasChildrenToVisit(unsigned int nodeID) const;
+	//Node-major like the top-down build, results get the classification of each edge shared by the whole subtree,
+	//edges classified differently in some children are stored in the children's updates
+	void _collectInsertedEdges(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int nodeID, const AABB& volume, const std::vector<unsigned int>& batchEdges, std::vector<int>& results, std::vector< std::vector<NodeEdgeUpdate> >& updates) const;
+	//Children have to be one level above the leaves, results are those of the children, updates are collected for the leaves
+	void _collectInsertedLeafBlockEdges(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int startingID, const std::vector<unsigned int>& batchEdges, std::vector<int> (&childResults)[OCTREE_NUM_CHILDREN], std::vector< std::vector<NodeEdgeUpdate> >& updates) const;
+	static void _addEdgeResult(Node& node, unsigned int edgeID, int result);
+	void _applyNodeEdgeUpdates(std::vector< std::vector<NodeEdgeUpdate> >& updates);
+	void _removeEdgesFromSubtree(const EdgeStore& edges, const EdgeUpdateBatch& batch, unsigned int nodeID, Node& node, const std::vector<unsigned int>& batchEdges, std::vector< std::vector<unsigned int> >& touchedNodes);
+	//Nodes without edges and children are deleted, together with ancestors left the same way
+	void _removeEmptyLeaves(const std::vector<unsigned int>& nodeIDs);
 
 	bool _isPointInsideNode(unsigned int nodeID, const glm::vec3& point) const;
 
 	int _getChildNodeContainingPoint(unsigned int parent, const glm::vec3& point) const;
 
+	void _printThreadPoolStats();
+
+	//Scratch memory for temporary node lists, one arena per pool worker plus one for the calling thread
+	BuildArena& _getWorkerArena() const;
+	void _releaseWorkerArenas();
+
+	//Edge test outcomes, one set of counters per pool worker plus one for the calling thread
+	EdgeTestCounters& _getWorkerEdgeTests() const;
+	void _collectWorkerEdgeTests();
+
 	std::shared_ptr<Octree> _octree;
+	bool _isAdaptive;
+	const std::atomic<bool>* _cancelFlag;
+
+	std::shared_ptr<BuildThreadPool> _threadPool;
+	std::mutex _octreeMutex;
+
+	mutable std::vector<BuildArena> _workerArenas;
+
+	BuildReport _buildReport;
+	mutable std::vector<EdgeTestCounters> _workerEdgeTests;
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+//Read-only array which either owns its content or references external memory (e.g. a mapped cache file)
+template<typename T>
+class PackedArray
+{
+public:
+	PackedArray() : _data(nullptr), _size(0) {}
+
+	PackedArray(const PackedArray& other)
+	{
+		*this = other;
+	}
+
+	PackedArray& operator=(const PackedArray& other)
+	{
+		_storage = other._storage;
+
+		if (other.isOwning())
+			_data = _storage.data();
+		else
+			_data = other._data;
+
+		_size = other._size;
+
+		return *this;
+	}
+
+	void assign(std::vector<T>&& values)
+	{
+		_storage.swap(values);
+		_storage.shrink_to_fit();
+
+		_data = _storage.data();
+		_size = _storage.size();
+	}
+
+	void reference(const T* data, size_t size)
+	{
+		std::vector<T>().swap(_storage);
+
+		_data = data;
+		_size = size;
+	}
+
+	void clear()
+	{
+		std::vector<T>().swap(_storage);
+
+		_data = nullptr;
+		_size = 0;
+	}
+
+	bool isOwning() const
+	{
+		return _data == nullptr || _data == _storage.data();
+	}
+
+	const T& operator[](size_t index) const
+	{
+		assert(index < _size);
+
+		return _data[index];
+	}
+
+	const T* data() const { return _data; }
+	size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	const T* begin() const { return _data; }
+	const T* end() const { return _data + _size; }
+
+	size_t getSizeBytes() const { return _size * sizeof(T); }
+
+private:
+	std::vector<T> _storage;
+
+	const T* _data;
+	size_t   _size;
+};
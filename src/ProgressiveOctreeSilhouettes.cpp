@@ -0,0 +1,179 @@
+#include "ProgressiveOctreeSilhouettes.hpp"
+#include "BruteForceSilhouettes.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+ProgressiveOctreeSilhouettes::ProgressiveOctreeSilhouettes() : _isCancelled(false), _structureVersion(0), _isComplete(false)
+{
+}
+
+ProgressiveOctreeSilhouettes::~ProgressiveOctreeSilhouettes()
+{
+	_stopBuild();
+}
+
+void ProgressiveOctreeSilhouettes::initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams)
+{
+	const auto params = reinterpret_cast<ProgressiveOctreeParams*>(customParams);
+
+	clear();
+
+	auto bruteForce = std::make_shared<BruteForceSilhouettes>();
+	bruteForce->initialize(edges, lightSpace, nullptr);
+	_setCurrentMethod(bruteForce, false);
+
+	_edges = edges;
+	_isCancelled = false;
+	_buildThread = std::thread(&ProgressiveOctreeSilhouettes::_build, this, *params, lightSpace);
+}
+
+void ProgressiveOctreeSilhouettes::_build(ProgressiveOctreeParams params, AABB lightSpace)
+{
+	if (!params.cachePath.empty())
+	{
+		auto cached = std::make_shared<OctreeSilhouettes>();
+
+		if (cached->load(params.cachePath, _edges, lightSpace, &params.octreeParams))
+		{
+			_setCurrentMethod(cached, true);
+			_edges = EdgeStore();
+			return;
+		}
+	}
+
+	//Builds in progress stop at their next node once clear is called
+	params.octreeParams.cancelFlag = &_isCancelled;
+
+	const unsigned int maxDepth = params.octreeParams.maxDepthLevel;
+	const unsigned int depthStep = std::max(params.previewDepthStep, 1u);
+
+	for (unsigned int depth = params.firstPreviewDepth; depth < maxDepth && !_isCancelled; depth += depthStep)
+	{
+		OctreeParams previewParams = params.octreeParams;
+		previewParams.maxDepthLevel = depth;
+		//Previews are replaced soon, updating them is not worth a copy of the edges
+		previewParams.allowIncrementalUpdates = false;
+
+		auto preview = std::make_shared<OctreeSilhouettes>();
+		preview->initialize(_edges, lightSpace, &previewParams);
+
+		if (!_isCancelled)
+			_setCurrentMethod(preview, false);
+	}
+
+	if (!_isCancelled)
+	{
+		auto octree = std::make_shared<OctreeSilhouettes>();
+		octree->initialize(_edges, lightSpace, &params.octreeParams);
+
+		if (!_isCancelled)
+		{
+			if (!params.cachePath.empty() && !octree->save(params.cachePath))
+				std::cerr << "Octree could not be cached to " << params.cachePath << "\n";
+
+			_setCurrentMethod(octree, true);
+		}
+	}
+
+	_edges = EdgeStore();
+}
+
+void ProgressiveOctreeSilhouettes::_setCurrentMethod(const std::shared_ptr<AbstractSilhouetteMethod>& method, bool isComplete)
+{
+	std::lock_guard<std::mutex> lock(_currentMutex);
+
+	_currentMethod = method;
+	_isComplete = isComplete;
+	++_structureVersion;
+}
+
+void ProgressiveOctreeSilhouettes::_stopBuild()
+{
+	_isCancelled = true;
+
+	if (_buildThread.joinable())
+		_buildThread.join();
+}
+
+ProgressiveOctreeSilhouettes::CurrentMethod ProgressiveOctreeSilhouettes::getCurrentMethod() const
+{
+	std::lock_guard<std::mutex> lock(_currentMutex);
+
+	return { _currentMethod, _structureVersion, _isComplete };
+}
+
+unsigned int ProgressiveOctreeSilhouettes::getStructureVersion() const
+{
+	return _structureVersion;
+}
+
+bool ProgressiveOctreeSilhouettes::isComplete() const
+{
+	std::lock_guard<std::mutex> lock(_currentMutex);
+
+	return _isComplete;
+}
+
+void ProgressiveOctreeSilhouettes::getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices)
+{
+	const auto current = getCurrentMethod();
+
+	if (current.method)
+		current.method->getSilhouetteEdgesForLightPos(lightPos, potentialEdgeIndices, silhouetteEdgeIndices);
+}
+
+void ProgressiveOctreeSilhouettes::visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const
+{
+	const auto current = getCurrentMethod();
+
+	if (current.method)
+		current.method->visitSilhouetteEdgesForLightPos(lightPos, visitor);
+}
+
+void ProgressiveOctreeSilhouettes::getSilhouetteEdgesForLightPositions(const glm::vec3* lightPositions, size_t numLights, MultiLightSilhouetteEdges& result) const
+{
+	const auto current = getCurrentMethod();
+
+	if (current.method)
+		current.method->getSilhouetteEdgesForLightPositions(lightPositions, numLights, result);
+}
+
+void ProgressiveOctreeSilhouettes::clear()
+{
+	_stopBuild();
+	_setCurrentMethod(nullptr, false);
+
+	_edges = EdgeStore();
+	_buildReport.clear();
+}
+
+uint64_t ProgressiveOctreeSilhouettes::getAccelerationStructureSizeBytes() const
+{
+	const auto current = getCurrentMethod();
+
+	return current.method ? current.method->getAccelerationStructureSizeBytes() : 0;
+}
+
+bool ProgressiveOctreeSilhouettes::save(const std::string& path) const
+{
+	const auto current = getCurrentMethod();
+
+	return current.isComplete && current.method->save(path);
+}
+
+bool ProgressiveOctreeSilhouettes::load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams)
+{
+	const auto params = reinterpret_cast<ProgressiveOctreeParams*>(customParams);
+
+	clear();
+
+	auto octree = std::make_shared<OctreeSilhouettes>();
+
+	if (!octree->load(path, edges, lightSpace, &params->octreeParams))
+		return false;
+
+	_setCurrentMethod(octree, true);
+
+	return true;
+}
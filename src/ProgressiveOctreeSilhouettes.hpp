@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "OctreeSilhouettes.hpp"
+
+struct ProgressiveOctreeParams
+{
+	ProgressiveOctreeParams() : firstPreviewDepth(1), previewDepthStep(2) {}
+
+	OctreeParams	octreeParams;
+
+	//Coarser octrees built before the full one, every level costs several times the one above it
+	//No previews if firstPreviewDepth is not above octreeParams.maxDepthLevel
+	unsigned int	firstPreviewDepth;
+	unsigned int	previewDepthStep;
+
+	//Tried before building and written once the full octree is built, not used if empty
+	std::string		cachePath;
+};
+
+//Builds the octree on a background thread, initialize returns right away
+//Until the first octree is done every edge is reported as potentially silhouette, preview octrees
+//then answer the queries until the full one replaces them
+class ProgressiveOctreeSilhouettes : public AbstractSilhouetteMethod
+{
+public:
+	struct CurrentMethod
+	{
+		std::shared_ptr<AbstractSilhouetteMethod>	method;
+		//Incremented each time a finer structure takes over
+		unsigned int								version;
+		bool										isComplete;
+	};
+
+	ProgressiveOctreeSilhouettes();
+	~ProgressiveOctreeSilhouettes();
+
+	void getSilhouetteEdgesForLightPos(const glm::vec3& lightPos, std::vector<int>& potentialEdgeIndices, std::vector<int>& silhouetteEdgeIndices) override;
+	void visitSilhouetteEdgesForLightPos(const glm::vec3& lightPos, SilhouetteEdgeVisitor& visitor) const override;
+	//Forwarded as a whole, so all lights are answered by the same structure
+	void getSilhouetteEdgesForLightPositions(const glm::vec3* lightPositions, size_t numLights, MultiLightSilhouetteEdges& result) const override;
+
+	//Custom params are ProgressiveOctreeParams
+	void initialize(const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
+	//Cancels the build, which stops at the next octree node, and waits for it
+	void clear() override;
+
+	uint64_t getAccelerationStructureSizeBytes() const override;
+
+	//Only the full octree is saved
+	bool save(const std::string& path) const override;
+	//Loads synchronously, custom params are ProgressiveOctreeParams
+	bool load(const std::string& path, const EdgeStore& edges, const AABB& lightSpace, void* customParams) override;
+
+	unsigned int getStructureVersion() const;
+	bool isComplete() const;
+
+	//Keep the method for consistent results across several queries, empty after clear
+	CurrentMethod getCurrentMethod() const;
+
+private:
+
+	void _build(ProgressiveOctreeParams params, AABB lightSpace);
+	void _setCurrentMethod(const std::shared_ptr<AbstractSilhouetteMethod>& method, bool isComplete);
+	void _stopBuild();
+
+	//Copy of the edges for the build thread, released once the build is done
+	EdgeStore									_edges;
+
+	std::thread									_buildThread;
+	std::atomic<bool>							_isCancelled;
+
+	mutable std::mutex							_currentMutex;
+	std::shared_ptr<AbstractSilhouetteMethod>	_currentMethod;
+	std::atomic<unsigned int>					_structureVersion;
+	bool										_isComplete;
+};
@@ -0,0 +1,200 @@
+#include "RobustPredicates.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+//Terms of the longest expansion orient3dExact builds, 6 products of three 2-term differences
+#define ROBUST_EXPANSION_CAPACITY 192
+
+//Exact sums and products of doubles as sums of non-overlapping doubles in increasing magnitude, zeros are left out
+//The sign of such an expansion is the sign of its last term
+struct RobustExpansion
+{
+	RobustExpansion() : size(0) {}
+
+	int getSign() const
+	{
+		return size ? (terms[size - 1] > 0 ? 1 : -1) : 0;
+	}
+
+	double	terms[ROBUST_EXPANSION_CAPACITY];
+	int		size;
+};
+
+static void twoSum(double a, double b, double& sum, double& error)
+{
+	sum = a + b;
+
+	const double bVirtual = sum - a;
+	const double aVirtual = sum - bVirtual;
+	error = (a - aVirtual) + (b - bVirtual);
+}
+
+static void twoProduct(double a, double b, double& product, double& error)
+{
+	product = a * b;
+	error = std::fma(a, b, -product);
+}
+
+static RobustExpansion makeDifference(float a, float b)
+{
+	double sum, error;
+	twoSum(double(a), -double(b), sum, error);
+
+	RobustExpansion result;
+	if (error != 0)
+		result.terms[result.size++] = error;
+	if (sum != 0)
+		result.terms[result.size++] = sum;
+
+	return result;
+}
+
+static void growExpansion(RobustExpansion& e, double b)
+{
+	double q = b;
+	int size = 0;
+
+	for (int i = 0; i < e.size; ++i)
+	{
+		double error;
+		twoSum(q, e.terms[i], q, error);
+
+		if (error != 0)
+			e.terms[size++] = error;
+	}
+
+	if (q != 0)
+	{
+		assert(size < ROBUST_EXPANSION_CAPACITY);
+		e.terms[size++] = q;
+	}
+
+	e.size = size;
+}
+
+static RobustExpansion addExpansions(const RobustExpansion& e, const RobustExpansion& f)
+{
+	RobustExpansion result = e;
+
+	for (int i = 0; i < f.size; ++i)
+		growExpansion(result, f.terms[i]);
+
+	return result;
+}
+
+static RobustExpansion negateExpansion(const RobustExpansion& e)
+{
+	RobustExpansion result = e;
+
+	for (int i = 0; i < result.size; ++i)
+		result.terms[i] = -result.terms[i];
+
+	return result;
+}
+
+static RobustExpansion scaleExpansion(const RobustExpansion& e, double b)
+{
+	RobustExpansion result;
+
+	if (e.size == 0 || b == 0)
+		return result;
+
+	double q, error;
+	twoProduct(e.terms[0], b, q, error);
+
+	if (error != 0)
+		result.terms[result.size++] = error;
+
+	for (int i = 1; i < e.size; ++i)
+	{
+		double product, productError, sum;
+		twoProduct(e.terms[i], b, product, productError);
+
+		twoSum(q, productError, sum, error);
+		if (error != 0)
+			result.terms[result.size++] = error;
+
+		twoSum(product, sum, q, error);
+		if (error != 0)
+			result.terms[result.size++] = error;
+	}
+
+	if (q != 0)
+		result.terms[result.size++] = q;
+
+	assert(result.size <= ROBUST_EXPANSION_CAPACITY);
+
+	return result;
+}
+
+static RobustExpansion multiplyExpansions(const RobustExpansion& e, const RobustExpansion& f)
+{
+	RobustExpansion result;
+
+	for (int i = 0; i < f.size; ++i)
+		result = addExpansions(result, scaleExpansion(e, f.terms[i]));
+
+	return result;
+}
+
+int RobustPredicates::orient3dExact(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+{
+	const RobustExpansion e1x = makeDifference(b.x, a.x), e1y = makeDifference(b.y, a.y), e1z = makeDifference(b.z, a.z);
+	const RobustExpansion e2x = makeDifference(c.x, a.x), e2y = makeDifference(c.y, a.y), e2z = makeDifference(c.z, a.z);
+	const RobustExpansion e3x = makeDifference(d.x, a.x), e3y = makeDifference(d.y, a.y), e3z = makeDifference(d.z, a.z);
+
+	const RobustExpansion nx = addExpansions(multiplyExpansions(e1y, e2z), negateExpansion(multiplyExpansions(e1z, e2y)));
+	const RobustExpansion ny = addExpansions(multiplyExpansions(e1z, e2x), negateExpansion(multiplyExpansions(e1x, e2z)));
+	const RobustExpansion nz = addExpansions(multiplyExpansions(e1x, e2y), negateExpansion(multiplyExpansions(e1y, e2x)));
+
+	const RobustExpansion det = addExpansions(addExpansions(multiplyExpansions(nx, e3x), multiplyExpansions(ny, e3y)), multiplyExpansions(nz, e3z));
+
+	return det.getSign();
+}
+
+static float roundUpToFloat(double value)
+{
+	float result = float(value);
+
+	if (double(result) < value)
+		result = std::nextafter(result, std::numeric_limits<float>::infinity());
+
+	return result;
+}
+
+void FilteredPlane::createFromPointsCCW(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3)
+{
+	//Normal of orient3d(v2, v3, v1, P), which has the orientation of Plane::createFromPointsCCW
+	const double e1x = double(v3.x) - v2.x, e1y = double(v3.y) - v2.y, e1z = double(v3.z) - v2.z;
+	const double e2x = double(v1.x) - v2.x, e2y = double(v1.y) - v2.y, e2z = double(v1.z) - v2.z;
+
+	const double nx = e1y * e2z - e1z * e2y;
+	const double ny = e1z * e2x - e1x * e2z;
+	const double nz = e1x * e2y - e1y * e2x;
+
+	//Bounds of the normal's components, their rounding errors are a few ulps of these
+	const double mx = std::fabs(e1y * e2z) + std::fabs(e1z * e2y);
+	const double my = std::fabs(e1z * e2x) + std::fabs(e1x * e2z);
+	const double mz = std::fabs(e1x * e2y) + std::fabs(e1y * e2x);
+
+	const double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+	if (!(length > 0) || !std::isfinite(length))
+	{
+		plane.equation = glm::vec4(0);
+		errorScale = errorOffset = std::numeric_limits<float>::infinity();
+		return;
+	}
+
+	const double scale = 1.0 / length;
+	const double d = -(nx * v2.x + ny * v2.y + nz * v2.z);
+
+	plane.equation = glm::vec4(float(nx * scale), float(ny * scale), float(nz * scale), float(d * scale));
+
+	const double offsetBound = std::fabs(d) + mx * std::fabs(v2.x) + my * std::fabs(v2.y) + mz * std::fabs(v2.z);
+
+	errorScale = roundUpToFloat(ROBUST_PLANE_ERROR_BOUND * std::max(mx, std::max(my, mz)) * scale);
+	errorOffset = roundUpToFloat(ROBUST_PLANE_ERROR_BOUND * offsetBound * scale) + ROBUST_PLANE_UNDERFLOW_BOUND;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Plane.hpp"
+
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <cmath>
+
+//Error of orient3d evaluated in double for float inputs stays below 8 unit roundoffs of the permanent, twice that for safety
+#define ROBUST_ORIENT3D_ERROR_BOUND (8.0 * DBL_EPSILON)
+//Error of a FilteredPlane evaluated in float, about 5 unit roundoffs including the rounding of the stored plane,
+//the rest leaves room for rounding the bound itself
+#define ROBUST_PLANE_ERROR_BOUND (4.0 * FLT_EPSILON)
+//Covers results rounded to subnormals, where the error is not relative
+#define ROBUST_PLANE_UNDERFLOW_BOUND 7.2e-43f
+
+//Orientation predicates with a fast filter in floating point and an exact fallback,
+//used only when the filter cannot prove the sign
+namespace RobustPredicates
+{
+	//Sign of dot(cross(b - a, c - a), d - a) computed with exact arithmetic
+	int orient3dExact(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d);
+
+	//Sign of dot(cross(b - a, c - a), d - a), exact for all finite inputs
+	inline int orient3d(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+	{
+		const double e1x = double(b.x) - a.x, e1y = double(b.y) - a.y, e1z = double(b.z) - a.z;
+		const double e2x = double(c.x) - a.x, e2y = double(c.y) - a.y, e2z = double(c.z) - a.z;
+		const double e3x = double(d.x) - a.x, e3y = double(d.y) - a.y, e3z = double(d.z) - a.z;
+
+		const double e1ye2z = e1y * e2z, e1ze2y = e1z * e2y;
+		const double e1ze2x = e1z * e2x, e1xe2z = e1x * e2z;
+		const double e1xe2y = e1x * e2y, e1ye2x = e1y * e2x;
+
+		const double det = (e1ye2z - e1ze2y) * e3x + (e1ze2x - e1xe2z) * e3y + (e1xe2y - e1ye2x) * e3z;
+		const double permanent = (std::fabs(e1ye2z) + std::fabs(e1ze2y)) * std::fabs(e3x)
+			+ (std::fabs(e1ze2x) + std::fabs(e1xe2z)) * std::fabs(e3y)
+			+ (std::fabs(e1xe2y) + std::fabs(e1ye2x)) * std::fabs(e3z);
+		const double errorBound = ROBUST_ORIENT3D_ERROR_BOUND * permanent;
+
+		if (det > errorBound)
+			return 1;
+		if (-det > errorBound)
+			return -1;
+
+		return orient3dExact(a, b, c, d);
+	}
+};
+
+//Plane of a triangle together with a bound on how far testPlanePoint can be from the exact orientation,
+//scaled to the plane: |value(P) - exact(P)| <= errorScale * (|P.x| + |P.y| + |P.z|) + errorOffset
+//Values farther from zero than the bound have the sign of orient3d, the others have to be decided exactly
+struct FilteredPlane
+{
+	Plane	plane;
+	float	errorScale;
+	float	errorOffset;
+
+	//Same orientation as Plane::createFromPointsCCW, degenerate triangles get an infinite bound
+	void createFromPointsCCW(const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3);
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+//Receives query results as ranges pointing into the acceleration structure (or into a small decode buffer)
+//Ranges are only valid during the call, a query may call each function any number of times
+class SilhouetteEdgeVisitor
+{
+public:
+	virtual ~SilhouetteEdgeVisitor() {}
+
+	virtual void visitPotentialEdges(const unsigned int* begin, const unsigned int* end) = 0;
+	//Entries are encoded with encodeSilhouetteEdge
+	virtual void visitSilhouetteEdges(const int* begin, const int* end) = 0;
+};
+
+//Appends the visited ranges to vectors, the way getSilhouetteEdgesForLightPos returns them
+class SilhouetteEdgeCollector : public SilhouetteEdgeVisitor
+{
+public:
+	SilhouetteEdgeCollector(std::vector<int>& potential, std::vector<int>& silhouette) : _potential(potential), _silhouette(silhouette) {}
+
+	void visitPotentialEdges(const unsigned int* begin, const unsigned int* end) override
+	{
+		_potential.insert(_potential.end(), begin, end);
+	}
+
+	void visitSilhouetteEdges(const int* begin, const int* end) override
+	{
+		_silhouette.insert(_silhouette.end(), begin, end);
+	}
+
+private:
+	std::vector<int>& _potential;
+	std::vector<int>& _silhouette;
+};
@@ -0,0 +1,205 @@
+#include "StructureCache.hpp"
+
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+	struct CacheFileHeader
+	{
+		char	 magic[8];
+		uint32_t version;
+		uint32_t methodType;
+		uint64_t edgesHash;
+		uint64_t lightSpaceHash;
+		uint64_t paramsHash;
+		uint32_t numSections;
+		uint32_t reserved;
+	};
+
+	struct CacheSectionEntry
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	const char CACHE_MAGIC[8] = { 'H', 'S', 'V', 'C', 'A', 'C', 'H', 'E' };
+
+	uint64_t alignOffset(uint64_t offset)
+	{
+		return (offset + STRUCTURE_CACHE_SECTION_ALIGNMENT - 1) / STRUCTURE_CACHE_SECTION_ALIGNMENT * STRUCTURE_CACHE_SECTION_ALIGNMENT;
+	}
+}
+
+CacheHasher::CacheHasher()
+{
+	_hash = 14695981039346656037ull;
+}
+
+void CacheHasher::add(const void* data, size_t sizeBytes)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < sizeBytes; ++i)
+	{
+		_hash ^= bytes[i];
+		_hash *= 1099511628211ull;
+	}
+}
+
+uint64_t CacheHasher::getHash() const
+{
+	return _hash;
+}
+
+uint64_t CacheHasher::hashEdges(const EdgeStore& edges)
+{
+	CacheHasher hasher;
+
+	hasher.addValue(uint64_t(edges.size()));
+
+	const unsigned int numEdges = unsigned(edges.size());
+	for (unsigned int i = 0; i < numEdges; ++i)
+	{
+		const unsigned int numOppositeVertices = edges.getNumOppositeVertices(i);
+
+		hasher.addValue(edges.getLowerPoint(i));
+		hasher.addValue(edges.getHigherPoint(i));
+		hasher.addValue(uint32_t(numOppositeVertices));
+
+		for (unsigned int j = 0; j < numOppositeVertices; ++j)
+			hasher.addValue(edges.getOppositeVertex(i, j));
+	}
+
+	return hasher.getHash();
+}
+
+uint64_t CacheHasher::hashAabb(const AABB& bbox)
+{
+	CacheHasher hasher;
+
+	hasher.addValue(bbox.getMinPoint());
+	hasher.addValue(bbox.getMaxPoint());
+
+	return hasher.getHash();
+}
+
+StructureCacheWriter::StructureCacheWriter(const StructureCacheKey& key)
+{
+	_key = key;
+}
+
+bool StructureCacheWriter::saveToFile(const std::string& path) const
+{
+	if (!StructureCacheReader::isHostLittleEndian())
+		return false;
+
+	CacheFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = STRUCTURE_CACHE_VERSION;
+	header.methodType = _key.methodType;
+	header.edgesHash = _key.edgesHash;
+	header.lightSpaceHash = _key.lightSpaceHash;
+	header.paramsHash = _key.paramsHash;
+	header.numSections = uint32_t(_sections.size());
+
+	std::vector<CacheSectionEntry> table(_sections.size());
+
+	uint64_t offset = alignOffset(sizeof(CacheFileHeader) + table.size() * sizeof(CacheSectionEntry));
+	for (size_t i = 0; i < _sections.size(); ++i)
+	{
+		table[i].offset = offset;
+		table[i].size = _sections[i].second;
+
+		offset = alignOffset(offset + _sections[i].second);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(CacheSectionEntry));
+
+	const char padding[STRUCTURE_CACHE_SECTION_ALIGNMENT] = {};
+	uint64_t written = sizeof(CacheFileHeader) + table.size() * sizeof(CacheSectionEntry);
+
+	for (size_t i = 0; i < _sections.size(); ++i)
+	{
+		file.write(padding, std::streamsize(table[i].offset - written));
+		file.write(reinterpret_cast<const char*>(_sections[i].first), std::streamsize(_sections[i].second));
+
+		written = table[i].offset + _sections[i].second;
+	}
+
+	return file.good();
+}
+
+StructureCacheReader::StructureCacheReader()
+{
+	_numSections = _nextSection = 0;
+}
+
+bool StructureCacheReader::isHostLittleEndian()
+{
+	const uint32_t value = 1;
+	unsigned char firstByte;
+	memcpy(&firstByte, &value, 1);
+
+	return firstByte == 1;
+}
+
+bool StructureCacheReader::open(const std::string& path, const StructureCacheKey& key)
+{
+	_file.reset();
+	_numSections = _nextSection = 0;
+
+	if (!isHostLittleEndian())
+		return false;
+
+	auto file = std::make_shared<MappedFile>();
+	if (!file->open(path) || file->getSize() < sizeof(CacheFileHeader))
+		return false;
+
+	CacheFileHeader header;
+	memcpy(&header, file->getData(), sizeof(header));
+
+	if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != STRUCTURE_CACHE_VERSION)
+		return false;
+
+	if (header.methodType != key.methodType || header.edgesHash != key.edgesHash || header.lightSpaceHash != key.lightSpaceHash || header.paramsHash != key.paramsHash)
+		return false;
+
+	if (file->getSize() < sizeof(CacheFileHeader) + uint64_t(header.numSections) * sizeof(CacheSectionEntry))
+		return false;
+
+	_file = file;
+	_numSections = header.numSections;
+
+	return true;
+}
+
+bool StructureCacheReader::_readSection(const unsigned char*& data, uint64_t& sizeBytes)
+{
+	if (!_file || _nextSection >= _numSections)
+		return false;
+
+	CacheSectionEntry entry;
+	memcpy(&entry, _file->getData() + sizeof(CacheFileHeader) + _nextSection * sizeof(CacheSectionEntry), sizeof(entry));
+
+	if (entry.offset > _file->getSize() || entry.size > (_file->getSize() - entry.offset))
+		return false;
+
+	data = _file->getData() + entry.offset;
+	sizeBytes = entry.size;
+
+	++_nextSection;
+
+	return true;
+}
+
+std::shared_ptr<MappedFile> StructureCacheReader::getMappedFile() const
+{
+	return _file;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "EdgeStore.hpp"
+#include "AABB.hpp"
+#include "MappedFile.hpp"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#define STRUCTURE_CACHE_VERSION 6u
+
+//Sections are aligned so that arrays can be used directly from the mapped file
+#define STRUCTURE_CACHE_SECTION_ALIGNMENT 64u
+
+enum class SilhouetteMethodType : uint32_t
+{
+	OCTREE = 1,
+	BIT_ARRAY_VOXELS = 2
+};
+
+//Identifies the input a cached structure was built from
+struct StructureCacheKey
+{
+	uint32_t methodType;
+	uint64_t edgesHash;
+	uint64_t lightSpaceHash;
+	uint64_t paramsHash;
+};
+
+//64-bit FNV-1a
+class CacheHasher
+{
+public:
+	CacheHasher();
+
+	void add(const void* data, size_t sizeBytes);
+
+	template<typename T>
+	void addValue(const T& value)
+	{
+		add(&value, sizeof(T));
+	}
+
+	uint64_t getHash() const;
+
+	static uint64_t hashEdges(const EdgeStore& edges);
+	static uint64_t hashAabb(const AABB& bbox);
+
+private:
+	uint64_t _hash;
+};
+
+//File layout (little-endian):
+//header | section table (offset, size per section) | sections, each aligned to STRUCTURE_CACHE_SECTION_ALIGNMENT
+class StructureCacheWriter
+{
+public:
+	StructureCacheWriter(const StructureCacheKey& key);
+
+	template<typename T>
+	void writeArray(const T* data, size_t count)
+	{
+		_sections.push_back(std::make_pair(reinterpret_cast<const unsigned char*>(data), uint64_t(count * sizeof(T))));
+	}
+
+	bool saveToFile(const std::string& path) const;
+
+private:
+	StructureCacheKey _key;
+
+	std::vector< std::pair<const unsigned char*, uint64_t> > _sections;
+};
+
+class StructureCacheReader
+{
+public:
+	StructureCacheReader();
+
+	//Fails if the file does not exist, is malformed, or was built from a different input
+	bool open(const std::string& path, const StructureCacheKey& key);
+
+	//Returns a pointer into the mapped file, nothing is copied
+	template<typename T>
+	bool readArray(const T*& data, size_t& count)
+	{
+		const unsigned char* sectionData = nullptr;
+		uint64_t sectionSize = 0;
+
+		if (!_readSection(sectionData, sectionSize) || (sectionSize % sizeof(T)) != 0)
+			return false;
+
+		data = reinterpret_cast<const T*>(sectionData);
+		count = size_t(sectionSize / sizeof(T));
+
+		return true;
+	}
+
+	//Mapping has to outlive all arrays referencing it
+	std::shared_ptr<MappedFile> getMappedFile() const;
+
+	static bool isHostLittleEndian();
+
+private:
+	bool _readSection(const unsigned char*& data, uint64_t& sizeBytes);
+
+	std::shared_ptr<MappedFile> _file;
+
+	uint32_t _numSections;
+	uint32_t _nextSection;
+};
@@ -0,0 +1,237 @@
+#include "SyblingEdgeClassifier.hpp"
+
+#ifdef SYBLING_CLASSIFIER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define SYBLING_CLASSIFIER_TARGET_AVX
+#else
+#define SYBLING_CLASSIFIER_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+SyblingEdgeClassifier::SyblingEdgeClassifier() : SyblingEdgeClassifier(getBestImplementation())
+{
+}
+
+SyblingEdgeClassifier::SyblingEdgeClassifier(Implementation implementation)
+{
+	_implementation = _isSupported(implementation) ? implementation : getBestImplementation();
+
+	switch (_implementation)
+	{
+#ifdef SYBLING_CLASSIFIER_X86
+	case Implementation::AVX:
+		_testPlane = &SyblingEdgeClassifier::_testPlaneAvx;
+		break;
+	case Implementation::SSE:
+		_testPlane = &SyblingEdgeClassifier::_testPlaneSse;
+		break;
+#endif
+	default:
+		_testPlane = &SyblingEdgeClassifier::_testPlaneScalar;
+	}
+}
+
+bool SyblingEdgeClassifier::_isSupported(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case Implementation::SCALAR:
+		return true;
+#ifdef SYBLING_CLASSIFIER_X86
+	case Implementation::SSE:
+		//Part of x86-64
+		return true;
+	case Implementation::AVX:
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+
+		const bool isAvxEnabled = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+		return isAvxEnabled && (_xgetbv(0) & 6) == 6;
+#else
+		return __builtin_cpu_supports("avx");
+#endif
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+SyblingEdgeClassifier::Implementation SyblingEdgeClassifier::getBestImplementation()
+{
+	//AVX is not preferred, 8 lanes measured no faster than two 4-wide halves, see SyblingClassifierBenchmark
+	static const Implementation best = _isSupported(Implementation::SSE) ? Implementation::SSE : Implementation::SCALAR;
+
+	return best;
+}
+
+SyblingEdgeClassifier::Implementation SyblingEdgeClassifier::getImplementation() const
+{
+	return _implementation;
+}
+
+void SyblingEdgeClassifier::setVolumes(const AABB (&volumes)[SYBLING_CLASSIFIER_NUM_VOLUMES])
+{
+	for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+	{
+		_volumes[i] = volumes[i];
+
+		//Same corners as testAabbPlane
+		const glm::vec3 minPoint = volumes[i].getMinPoint();
+		const glm::vec3 maxPoint = volumes[i].getMaxPoint();
+
+		_corners.minX[i] = minPoint.x;
+		_corners.minY[i] = minPoint.y;
+		_corners.minZ[i] = minPoint.z;
+		_corners.maxX[i] = maxPoint.x;
+		_corners.maxY[i] = maxPoint.y;
+		_corners.maxZ[i] = maxPoint.z;
+		_corners.reach[i] = GeometryOps::getAabbReach(volumes[i]);
+	}
+}
+
+void SyblingEdgeClassifier::classifyEdge(const EdgeStore& edges, unsigned int edgeID, EdgeSilhouetness (&results)[SYBLING_CLASSIFIER_NUM_VOLUMES]) const
+{
+	unsigned int above1, below1, crossing1, above2, below2, crossing2;
+	_testPlane(_corners, edges.getPlane(edgeID, 0), above1, below1, crossing1);
+	_testPlane(_corners, edges.getPlane(edgeID, 1), above2, below2, crossing2);
+
+	//Volumes not intersected by either plane see the edge the same from everywhere
+	const unsigned int potentialMask = crossing1 | crossing2;
+	const unsigned int separatedMask = (above1 | below1) & (above2 | below2);
+
+	for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+	{
+		if ((potentialMask >> i) & 1)
+		{
+			results[i] = EdgeSilhouetness::EDGE_POTENTIALLY_SILHOUETTE;
+			continue;
+		}
+
+		if (!((separatedMask >> i) & 1))
+		{
+			results[i] = GeometryOps::testEdgeSpaceAabb(edges, edgeID, _volumes[i]);
+			continue;
+		}
+
+		const int multiplicity = GeometryOps::calcEdgeMultiplicity(edges, edgeID, glm::vec3(_corners.minX[i], _corners.minY[i], _corners.minZ[i]));
+
+		if (multiplicity > 0)
+			results[i] = EdgeSilhouetness::EDGE_IS_SILHOUETTE_PLUS;
+		else if (multiplicity < 0)
+			results[i] = EdgeSilhouetness::EDGE_IS_SILHOUETTE_MINUS;
+		else
+			results[i] = EdgeSilhouetness::EDGE_NOT_SILHOUETTE;
+	}
+}
+
+void SyblingEdgeClassifier::_testPlaneScalar(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask)
+{
+	const glm::vec4& eq = plane.plane.equation;
+
+	//Corner with the highest value of the plane equation, the lowest one is on the opposite side
+	const float* farX = eq.x > 0 ? corners.maxX : corners.minX;
+	const float* farY = eq.y > 0 ? corners.maxY : corners.minY;
+	const float* farZ = eq.z > 0 ? corners.maxZ : corners.minZ;
+	const float* nearX = eq.x > 0 ? corners.minX : corners.maxX;
+	const float* nearY = eq.y > 0 ? corners.minY : corners.maxY;
+	const float* nearZ = eq.z > 0 ? corners.minZ : corners.maxZ;
+
+	aboveMask = 0;
+	belowMask = 0;
+	crossingMask = 0;
+
+	for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; ++i)
+	{
+		const float highest = GeometryOps::testPlanePoint(plane.plane, glm::vec3(farX[i], farY[i], farZ[i]));
+		const float lowest = GeometryOps::testPlanePoint(plane.plane, glm::vec3(nearX[i], nearY[i], nearZ[i]));
+		const float errorBound = plane.errorScale * corners.reach[i] + plane.errorOffset;
+
+		aboveMask |= unsigned(lowest > errorBound) << i;
+		belowMask |= unsigned(highest < -errorBound) << i;
+		crossingMask |= unsigned(lowest < -errorBound && highest > errorBound) << i;
+	}
+}
+
+#ifdef SYBLING_CLASSIFIER_X86
+void SyblingEdgeClassifier::_testPlaneSse(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask)
+{
+	const glm::vec4& eq = plane.plane.equation;
+
+	const float* farX = eq.x > 0 ? corners.maxX : corners.minX;
+	const float* farY = eq.y > 0 ? corners.maxY : corners.minY;
+	const float* farZ = eq.z > 0 ? corners.maxZ : corners.minZ;
+	const float* nearX = eq.x > 0 ? corners.minX : corners.maxX;
+	const float* nearY = eq.y > 0 ? corners.minY : corners.maxY;
+	const float* nearZ = eq.z > 0 ? corners.minZ : corners.maxZ;
+
+	const __m128 a = _mm_set1_ps(eq.x);
+	const __m128 b = _mm_set1_ps(eq.y);
+	const __m128 c = _mm_set1_ps(eq.z);
+	const __m128 d = _mm_set1_ps(eq.w);
+	const __m128 errorScale = _mm_set1_ps(plane.errorScale);
+	const __m128 errorOffset = _mm_set1_ps(plane.errorOffset);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	aboveMask = 0;
+	belowMask = 0;
+	crossingMask = 0;
+
+	for (unsigned int i = 0; i < SYBLING_CLASSIFIER_NUM_VOLUMES; i += 4)
+	{
+		//Same order of operations as testPlanePoint
+		const __m128 highest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(farX + i)), _mm_mul_ps(b, _mm_loadu_ps(farY + i))), _mm_mul_ps(c, _mm_loadu_ps(farZ + i))), d);
+		const __m128 lowest = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(nearX + i)), _mm_mul_ps(b, _mm_loadu_ps(nearY + i))), _mm_mul_ps(c, _mm_loadu_ps(nearZ + i))), d);
+		const __m128 errorBound = _mm_add_ps(_mm_mul_ps(errorScale, _mm_loadu_ps(corners.reach + i)), errorOffset);
+		const __m128 negErrorBound = _mm_xor_ps(errorBound, signMask);
+
+		const __m128 isAbove = _mm_cmpgt_ps(lowest, errorBound);
+		const __m128 isBelow = _mm_cmplt_ps(highest, negErrorBound);
+		const __m128 isCrossing = _mm_and_ps(_mm_cmplt_ps(lowest, negErrorBound), _mm_cmpgt_ps(highest, errorBound));
+
+		aboveMask |= unsigned(_mm_movemask_ps(isAbove)) << i;
+		belowMask |= unsigned(_mm_movemask_ps(isBelow)) << i;
+		crossingMask |= unsigned(_mm_movemask_ps(isCrossing)) << i;
+	}
+}
+
+SYBLING_CLASSIFIER_TARGET_AVX void SyblingEdgeClassifier::_testPlaneAvx(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask)
+{
+	const glm::vec4& eq = plane.plane.equation;
+
+	const float* farX = eq.x > 0 ? corners.maxX : corners.minX;
+	const float* farY = eq.y > 0 ? corners.maxY : corners.minY;
+	const float* farZ = eq.z > 0 ? corners.maxZ : corners.minZ;
+	const float* nearX = eq.x > 0 ? corners.minX : corners.maxX;
+	const float* nearY = eq.y > 0 ? corners.minY : corners.maxY;
+	const float* nearZ = eq.z > 0 ? corners.minZ : corners.maxZ;
+
+	const __m256 a = _mm256_set1_ps(eq.x);
+	const __m256 b = _mm256_set1_ps(eq.y);
+	const __m256 c = _mm256_set1_ps(eq.z);
+	const __m256 d = _mm256_set1_ps(eq.w);
+	const __m256 errorScale = _mm256_set1_ps(plane.errorScale);
+	const __m256 errorOffset = _mm256_set1_ps(plane.errorOffset);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	const __m256 highest = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, _mm256_loadu_ps(farX)), _mm256_mul_ps(b, _mm256_loadu_ps(farY))), _mm256_mul_ps(c, _mm256_loadu_ps(farZ))), d);
+	const __m256 lowest = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, _mm256_loadu_ps(nearX)), _mm256_mul_ps(b, _mm256_loadu_ps(nearY))), _mm256_mul_ps(c, _mm256_loadu_ps(nearZ))), d);
+	const __m256 errorBound = _mm256_add_ps(_mm256_mul_ps(errorScale, _mm256_loadu_ps(corners.reach)), errorOffset);
+	const __m256 negErrorBound = _mm256_xor_ps(errorBound, signMask);
+
+	const __m256 isAbove = _mm256_cmp_ps(lowest, errorBound, _CMP_GT_OQ);
+	const __m256 isBelow = _mm256_cmp_ps(highest, negErrorBound, _CMP_LT_OQ);
+	const __m256 isCrossing = _mm256_and_ps(_mm256_cmp_ps(lowest, negErrorBound, _CMP_LT_OQ), _mm256_cmp_ps(highest, errorBound, _CMP_GT_OQ));
+
+	aboveMask = unsigned(_mm256_movemask_ps(isAbove));
+	belowMask = unsigned(_mm256_movemask_ps(isBelow));
+	crossingMask = unsigned(_mm256_movemask_ps(isCrossing));
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "GeometryOperations.hpp"
+
+#define SYBLING_CLASSIFIER_NUM_VOLUMES 8
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SYBLING_CLASSIFIER_X86
+#endif
+
+//Tests one edge against the volumes of 8 syblings at once, with the same results as testEdgeSpaceAabb
+//A plane is evaluated only in the corners nearest and farthest along its normal, rounding is monotonic,
+//so the float values there are the extremes of the 8 values testAabbPlane computes
+//Volumes the error bound of the plane cannot decide are passed to testEdgeSpaceAabb
+//The 8-wide path targets AVX, not AVX2, it uses only float instructions, it has to be requested explicitly
+class SyblingEdgeClassifier
+{
+public:
+	enum class Implementation : int
+	{
+		SCALAR = 0,
+		SSE = 1,
+		AVX = 2
+	};
+
+	//Uses SSE when the CPU supports it
+	SyblingEdgeClassifier();
+	//Unsupported implementations are replaced by getBestImplementation()
+	explicit SyblingEdgeClassifier(Implementation implementation);
+
+	static Implementation getBestImplementation();
+	Implementation getImplementation() const;
+
+	void setVolumes(const AABB (&volumes)[SYBLING_CLASSIFIER_NUM_VOLUMES]);
+
+	//Edge has to have two neighbouring triangles
+	void classifyEdge(const EdgeStore& edges, unsigned int edgeID, EdgeSilhouetness (&results)[SYBLING_CLASSIFIER_NUM_VOLUMES]) const;
+
+	//Coordinates of the lower and upper corners, one lane per volume
+	struct Corners
+	{
+		float minX[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		float minY[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		float minZ[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		float maxX[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		float maxY[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		float maxZ[SYBLING_CLASSIFIER_NUM_VOLUMES];
+		//GeometryOps::getAabbReach of the volumes
+		float reach[SYBLING_CLASSIFIER_NUM_VOLUMES];
+	};
+
+	//Bit i of aboveMask is set if volume i is certainly entirely above the plane, of belowMask if entirely below,
+	//of crossingMask if it certainly has corners on both sides, volumes with none of the bits set need an exact test
+	typedef void(*PlaneTest)(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask);
+
+private:
+	static void _testPlaneScalar(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask);
+#ifdef SYBLING_CLASSIFIER_X86
+	static void _testPlaneSse(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask);
+	static void _testPlaneAvx(const Corners& corners, const FilteredPlane& plane, unsigned int& aboveMask, unsigned int& belowMask, unsigned int& crossingMask);
+#endif
+
+	static bool _isSupported(Implementation implementation);
+
+	Implementation	_implementation;
+	PlaneTest		_testPlane;
+
+	Corners			_corners;
+	AABB			_volumes[SYBLING_CLASSIFIER_NUM_VOLUMES];
+};